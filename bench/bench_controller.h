@@ -0,0 +1,56 @@
+/*
+ * Copyright 2022 Ryan Daum
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <public.sdk/source/vst/vsteditcontroller.h>
+
+#include <cstdint>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "pluginterfaces/base/fstrdefs.h"
+
+namespace vstwebview::bench {
+
+/**
+ * Stands in for a large plugin's controller: 'count' range parameters with
+ * random 32-bit IDs, as plugins that hash their parameter names into IDs
+ * have, so lookups cannot rely on IDs being small or dense.
+ */
+class BenchController : public Steinberg::Vst::EditControllerEx1 {
+ public:
+  explicit BenchController(int count, uint32_t seed = 1) {
+    std::mt19937 random(seed);
+    std::set<Steinberg::Vst::ParamID> used;
+    while (static_cast<int>(ids_.size()) < count) {
+      Steinberg::Vst::ParamID id = random();
+      if (!used.insert(id).second) continue;
+      ids_.push_back(id);
+      parameters.addParameter(new Steinberg::Vst::RangeParameter(
+          STR16("Param"), id, STR16("dB"), -60, 12, 0));
+    }
+  }
+
+  // In registration order.
+  const std::vector<Steinberg::Vst::ParamID> &ids() const { return ids_; }
+
+ private:
+  std::vector<Steinberg::Vst::ParamID> ids_;
+};
+
+}  // namespace vstwebview::bench
@@ -0,0 +1,253 @@
+/*
+ * Copyright 2022 Ryan Daum
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <dirent.h>
+#include <gtk/gtk.h>
+#include <gtk/gtkx.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pluginterfaces/gui/iplugview.h"
+
+namespace vstwebview::bench {
+
+/**
+ * Stands in for the parts of a Linux VST3 host the editor benchmarks need: a
+ * top-level window to embed editors into, and an IPlugFrame that is also the
+ * IRunLoop, whose timers the benchmark pumps itself.
+ */
+class BenchHost : public Steinberg::IPlugFrame,
+                  public Steinberg::Linux::IRunLoop {
+ public:
+  BenchHost(int width = 800, int height = 600) {
+    if (!gtk_init_check(nullptr, nullptr)) return;
+    window_ = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+    gtk_window_set_default_size(GTK_WINDOW(window_), width, height);
+    gtk_widget_show_all(window_);
+    Pump();
+  }
+
+  ~BenchHost() {
+    if (!window_) return;
+    gtk_widget_destroy(window_);
+    Pump();
+  }
+
+  // False if GTK could not open a display.
+  bool has_display() const { return window_ != nullptr; }
+
+  // The X11 window editors are attached to.
+  void *window() const {
+    return reinterpret_cast<void *>(
+        GDK_WINDOW_XID(gtk_widget_get_window(window_)));
+  }
+
+  /**
+   * Fire due timers until 'done' returns true or 'timeout' passes. Returns
+   * whether 'done' was met.
+   */
+  bool RunUntil(const std::function<bool()> &done,
+                std::chrono::steady_clock::duration timeout) {
+    auto end = std::chrono::steady_clock::now() + timeout;
+    while (!done()) {
+      auto now = std::chrono::steady_clock::now();
+      if (now >= end) return false;
+      auto next = end;
+      // Handlers may unregister themselves, so work on a copy.
+      auto timers = timers_;
+      for (auto &timer : timers) {
+        auto it = std::find_if(timers_.begin(), timers_.end(),
+                               [&timer](const Timer &t) {
+                                 return t.handler == timer.handler;
+                               });
+        if (it == timers_.end()) continue;
+        if (it->due <= now) {
+          it->due = now + it->interval;
+          timer.handler->onTimer();
+        }
+      }
+      for (const auto &timer : timers_) next = std::min(next, timer.due);
+      Pump();
+      std::this_thread::sleep_until(
+          std::min(next, std::chrono::steady_clock::now() +
+                             std::chrono::milliseconds(16)));
+    }
+    return true;
+  }
+
+  void RunFor(std::chrono::steady_clock::duration duration) {
+    RunUntil([]() { return false; }, duration);
+  }
+
+  // IPlugFrame
+  Steinberg::tresult PLUGIN_API resizeView(Steinberg::IPlugView *,
+                                           Steinberg::ViewRect *) override {
+    return Steinberg::kResultOk;
+  }
+
+  // IRunLoop
+  Steinberg::tresult PLUGIN_API registerEventHandler(
+      Steinberg::Linux::IEventHandler *,
+      Steinberg::Linux::FileDescriptor) override {
+    return Steinberg::kNotImplemented;
+  }
+  Steinberg::tresult PLUGIN_API
+  unregisterEventHandler(Steinberg::Linux::IEventHandler *) override {
+    return Steinberg::kNotImplemented;
+  }
+  Steinberg::tresult PLUGIN_API registerTimer(
+      Steinberg::Linux::ITimerHandler *handler,
+      Steinberg::Linux::TimerInterval milliseconds) override {
+    auto interval = std::chrono::milliseconds(milliseconds);
+    timers_.push_back(
+        {handler, interval, std::chrono::steady_clock::now() + interval});
+    return Steinberg::kResultOk;
+  }
+  Steinberg::tresult PLUGIN_API
+  unregisterTimer(Steinberg::Linux::ITimerHandler *handler) override {
+    timers_.erase(std::remove_if(timers_.begin(), timers_.end(),
+                                 [handler](const Timer &timer) {
+                                   return timer.handler == handler;
+                                 }),
+                  timers_.end());
+    return Steinberg::kResultOk;
+  }
+
+  // The host owns itself; editors only borrow it.
+  Steinberg::tresult PLUGIN_API queryInterface(const Steinberg::TUID _iid,
+                                               void **obj) override {
+    QUERY_INTERFACE(_iid, obj, Steinberg::FUnknown::iid,
+                    Steinberg::IPlugFrame)
+    QUERY_INTERFACE(_iid, obj, Steinberg::IPlugFrame::iid,
+                    Steinberg::IPlugFrame)
+    QUERY_INTERFACE(_iid, obj, Steinberg::Linux::IRunLoop::iid,
+                    Steinberg::Linux::IRunLoop)
+    *obj = nullptr;
+    return Steinberg::kNoInterface;
+  }
+  Steinberg::uint32 PLUGIN_API addRef() override { return 1000; }
+  Steinberg::uint32 PLUGIN_API release() override { return 1000; }
+
+ private:
+  static void Pump() {
+    while (gtk_events_pending()) gtk_main_iteration();
+  }
+
+  struct Timer {
+    Steinberg::Linux::ITimerHandler *handler;
+    std::chrono::steady_clock::duration interval;
+    std::chrono::steady_clock::time_point due;
+  };
+  GtkWidget *window_ = nullptr;
+  std::vector<Timer> timers_;
+};
+
+// Resident set size of 'pid' in bytes, from /proc/<pid>/statm.
+inline size_t ResidentBytes(const std::string &pid = "self") {
+  FILE *file = std::fopen(("/proc/" + pid + "/statm").c_str(), "r");
+  if (!file) return 0;
+  unsigned long size = 0, resident = 0;
+  int fields = std::fscanf(file, "%lu %lu", &size, &resident);
+  std::fclose(file);
+  return fields == 2 ? resident * sysconf(_SC_PAGESIZE) : 0;
+}
+
+inline int OpenFileDescriptors() {
+  int count = 0;
+  DIR *dir = opendir("/proc/self/fd");
+  if (!dir) return -1;
+  while (dirent *entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') count++;
+  }
+  closedir(dir);
+  // Less the one opendir itself holds.
+  return count - 1;
+}
+
+// User and system CPU time of this process, all threads.
+inline double ProcessCpuSeconds() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+/**
+ * Totals over the WebKit helper processes (web, network) this process has
+ * started. The benchmark is their only client, so unlike
+ * Webview::GetResourceUsage nothing has to be attributed to a view.
+ */
+struct HelperUsage {
+  int processes = 0;
+  double cpu_seconds = 0;
+  size_t resident_bytes = 0;
+};
+
+inline HelperUsage WebKitHelperUsage() {
+  HelperUsage usage;
+  DIR *proc = opendir("/proc");
+  if (!proc) return usage;
+  static const double ticks_per_second = sysconf(_SC_CLK_TCK);
+  int self = getpid();
+  while (dirent *entry = readdir(proc)) {
+    int pid = std::atoi(entry->d_name);
+    if (pid <= 0) continue;
+    FILE *file = std::fopen(("/proc/" + std::string(entry->d_name) + "/stat")
+                                .c_str(),
+                            "r");
+    if (!file) continue;
+    char buffer[1024];
+    size_t len = std::fread(buffer, 1, sizeof(buffer) - 1, file);
+    std::fclose(file);
+    buffer[len] = 0;
+    // The name is in parentheses and may itself contain spaces.
+    char *open = std::strchr(buffer, '(');
+    char *close = std::strrchr(buffer, ')');
+    if (!open || !close) continue;
+    std::string name(open + 1, close);
+    int parent_pid = 0;
+    unsigned long long utime = 0, stime = 0;
+    if (std::sscanf(close + 2,
+                    "%*c %d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu",
+                    &parent_pid, &utime, &stime) != 3 ||
+        parent_pid != self || name.compare(0, 6, "WebKit") != 0) {
+      continue;
+    }
+    usage.processes++;
+    usage.cpu_seconds += (utime + stime) / ticks_per_second;
+    usage.resident_bytes += ResidentBytes(entry->d_name);
+  }
+  closedir(proc);
+  return usage;
+}
+
+inline std::string ResourceURI(const std::string &name) {
+  return std::string("file://") + VSTWEBVIEW_BENCH_RESOURCES + "/" + name;
+}
+
+}  // namespace vstwebview::bench
@@ -0,0 +1,235 @@
+/*
+ * Copyright 2022 Ryan Daum
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Native cost of delivering processor messages to JS: Notify through the
+// subscription's compiled serializer, against building a nlohmann::json
+// object per message and dumping it, as the listener used to. The webview
+// discards the scripts, so what the engine does with them is not measured.
+//
+// Usage: message_listener_bench [messages per case, default 1000000]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "vstwebview/webview.h"
+#include "vstwebview/webview_message_listener.h"
+
+namespace {
+
+using Steinberg::tresult;
+using Steinberg::Vst::AttrID;
+
+// Counts what it is asked to evaluate and does nothing else.
+class NullWebview : public vstwebview::Webview {
+ public:
+  void SetTitle(const std::string &title) override {}
+  void SetViewSize(int width, int height, SizeHint hints) override {}
+  std::string ContentRootURI() const override { return ""; }
+  void EvalJS(const std::string &js, ResultCallback rs) override {
+    bytes += js.size();
+  }
+  void *PlatformWindow() const override { return nullptr; }
+  void Terminate() override {}
+
+  size_t bytes = 0;
+
+ protected:
+  void DispatchIn(vstwebview::DispatchFunction f) override { f(); }
+  void DoNavigate(const std::string &url) override {}
+  void SetDocumentScript(const std::string &js) override {}
+};
+
+class BenchAttributes : public Steinberg::Vst::IAttributeList {
+ public:
+  tresult PLUGIN_API setInt(AttrID id, Steinberg::int64 value) override {
+    ints_[id] = value;
+    return Steinberg::kResultTrue;
+  }
+  tresult PLUGIN_API getInt(AttrID id, Steinberg::int64 &value) override {
+    auto it = ints_.find(id);
+    if (it == ints_.end()) return Steinberg::kResultFalse;
+    value = it->second;
+    return Steinberg::kResultTrue;
+  }
+  tresult PLUGIN_API setFloat(AttrID id, double value) override {
+    floats_[id] = value;
+    return Steinberg::kResultTrue;
+  }
+  tresult PLUGIN_API getFloat(AttrID id, double &value) override {
+    auto it = floats_.find(id);
+    if (it == floats_.end()) return Steinberg::kResultFalse;
+    value = it->second;
+    return Steinberg::kResultTrue;
+  }
+  tresult PLUGIN_API setString(AttrID id,
+                               const Steinberg::Vst::TChar *string) override {
+    return Steinberg::kNotImplemented;
+  }
+  tresult PLUGIN_API getString(AttrID id, Steinberg::Vst::TChar *string,
+                               Steinberg::uint32 sizeInBytes) override {
+    return Steinberg::kResultFalse;
+  }
+  tresult PLUGIN_API setBinary(AttrID id, const void *data,
+                               Steinberg::uint32 sizeInBytes) override {
+    auto *bytes = static_cast<const char *>(data);
+    binaries_[id].assign(bytes, bytes + sizeInBytes);
+    return Steinberg::kResultTrue;
+  }
+  tresult PLUGIN_API getBinary(AttrID id, const void *&data,
+                               Steinberg::uint32 &sizeInBytes) override {
+    auto it = binaries_.find(id);
+    if (it == binaries_.end()) return Steinberg::kResultFalse;
+    data = it->second.data();
+    sizeInBytes = static_cast<Steinberg::uint32>(it->second.size());
+    return Steinberg::kResultTrue;
+  }
+
+  tresult PLUGIN_API queryInterface(const Steinberg::TUID _iid,
+                                    void **obj) override {
+    *obj = nullptr;
+    return Steinberg::kNoInterface;
+  }
+  // Lives on the benchmark's stack.
+  Steinberg::uint32 PLUGIN_API addRef() override { return 1000; }
+  Steinberg::uint32 PLUGIN_API release() override { return 1000; }
+
+ private:
+  std::map<std::string, Steinberg::int64> ints_;
+  std::map<std::string, double> floats_;
+  std::map<std::string, std::vector<char>> binaries_;
+};
+
+class BenchMessage : public Steinberg::Vst::IMessage {
+ public:
+  Steinberg::FIDString PLUGIN_API getMessageID() override {
+    return id_.c_str();
+  }
+  void PLUGIN_API setMessageID(Steinberg::FIDString id) override { id_ = id; }
+  Steinberg::Vst::IAttributeList *PLUGIN_API getAttributes() override {
+    return &attributes_;
+  }
+
+  tresult PLUGIN_API queryInterface(const Steinberg::TUID _iid,
+                                    void **obj) override {
+    *obj = nullptr;
+    return Steinberg::kNoInterface;
+  }
+  Steinberg::uint32 PLUGIN_API addRef() override { return 1000; }
+  Steinberg::uint32 PLUGIN_API release() override { return 1000; }
+
+ private:
+  std::string id_;
+  BenchAttributes attributes_;
+};
+
+using Attribute = vstwebview::WebviewMessageListener::MessageAttribute;
+
+// The listener's serialization before subscriptions were compiled: a json
+// object per message, dumped and concatenated into the call.
+void NotifyWithJson(vstwebview::Webview *webview, const std::string &receiver,
+                    const std::vector<Attribute> &descriptor,
+                    Steinberg::Vst::IMessage *message) {
+  auto attributes = message->getAttributes();
+  nlohmann::json j = {{"messageId", message->getMessageID()}};
+  for (const auto &attr : descriptor) {
+    switch (attr.type) {
+    case Attribute::Type::INT:
+      Steinberg::int64 i;
+      if (attributes->getInt(attr.name.c_str(), i) == Steinberg::kResultTrue)
+        j[attr.name] = i;
+      break;
+    case Attribute::Type::FLOAT:
+      double f;
+      if (attributes->getFloat(attr.name.c_str(), f) ==
+          Steinberg::kResultTrue)
+        j[attr.name] = f;
+      break;
+    default:
+      const void *addr;
+      Steinberg::uint32 size;
+      if (attributes->getBinary(attr.name.c_str(), addr, size) ==
+          Steinberg::kResultTrue) {
+        std::vector<double> data(size / sizeof(double));
+        std::memcpy(data.data(), addr, data.size() * sizeof(double));
+        j[attr.name] = data;
+      }
+      break;
+    }
+  }
+  webview->EvalJS(receiver + "(" + j.dump() + ");",
+                  [](const nlohmann::json &) {});
+}
+
+template <typename F>
+double MessagesPerSecond(int messages, F notify) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < messages; i++) notify();
+  return messages / std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+}
+
+void RunCase(const char *name, int messages, BenchMessage *message,
+             const std::vector<Attribute> &attributes) {
+  NullWebview webview;
+  vstwebview::WebviewMessageListener listener;
+  listener.Bind(&webview);
+  listener.Subscribe("onMessage", message->getMessageID(), attributes);
+
+  double compiled = MessagesPerSecond(
+      messages, [&listener, message]() { listener.Notify(message); });
+  double json = MessagesPerSecond(messages, [&webview, &attributes,
+                                             message]() {
+    NotifyWithJson(&webview, "onMessage", attributes, message);
+  });
+  std::printf("%-8s compiled %10.0f msg/s   json %10.0f msg/s   %.1fx\n",
+              name, compiled, json, compiled / json);
+  listener.Unbind(&webview);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  int messages = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+  // A level meter: a few scalars per message.
+  BenchMessage meter;
+  meter.setMessageID("meter");
+  meter.getAttributes()->setInt("frame", 123456789);
+  meter.getAttributes()->setFloat("left", 0.7071067811865476);
+  meter.getAttributes()->setFloat("right", 0.5);
+  RunCase("meter", messages, &meter,
+          {{"frame", Attribute::Type::INT},
+           {"left", Attribute::Type::FLOAT},
+           {"right", Attribute::Type::FLOAT}});
+
+  // A scope: a block of 256 samples.
+  BenchMessage scope;
+  scope.setMessageID("scope");
+  std::vector<double> samples(256);
+  for (size_t i = 0; i < samples.size(); i++) samples[i] = 0.001 * i - 0.1;
+  scope.getAttributes()->setBinary(
+      "samples", samples.data(),
+      static_cast<Steinberg::uint32>(samples.size() * sizeof(double)));
+  RunCase("scope", messages / 10, &scope,
+          {{"samples", Attribute::Type::BINARY}});
+  return 0;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2022 Ryan Daum
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Parameter lookup by ID: ParameterTable::Find against the SDK's
+// EditController::getParameterObject, which goes through the
+// ParameterContainer's std::map.
+//
+// Usage: parameter_table_bench [parameters, default 20000]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "bench_controller.h"
+#include "vstwebview/parameter_table.h"
+
+namespace {
+
+constexpr int kLookups = 10000000;
+
+template <typename F>
+double NanosecondsPerLookup(const std::vector<Steinberg::Vst::ParamID> &ids,
+                            F lookup) {
+  // Sum the results so the lookups cannot be optimised away.
+  uintptr_t sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kLookups; i++) {
+    sink += lookup(ids[i % ids.size()]);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  if (sink == 1) std::printf(" ");
+  return std::chrono::duration<double, std::nano>(elapsed).count() / kLookups;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  int count = argc > 1 ? std::atoi(argv[1]) : 20000;
+  vstwebview::bench::BenchController controller(count);
+
+  auto start = std::chrono::steady_clock::now();
+  vstwebview::ParameterTable table;
+  table.Build(&controller);
+  double build_ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+  // Look parameters up in an order unrelated to how they were added, as
+  // edits and change notifications arrive.
+  std::vector<Steinberg::Vst::ParamID> ids = controller.ids();
+  std::shuffle(ids.begin(), ids.end(), std::mt19937(2));
+
+  double map_ns = NanosecondsPerLookup(ids, [&controller](auto id) {
+    return reinterpret_cast<uintptr_t>(controller.getParameterObject(id));
+  });
+  double table_ns = NanosecondsPerLookup(ids, [&table](auto id) {
+    return static_cast<uintptr_t>(table.Find(id));
+  });
+
+  std::printf("%d parameters, table built in %.1f ms\n", count, build_ms);
+  std::printf("getParameterObject  %6.1f ns/lookup\n", map_ns);
+  std::printf("ParameterTable::Find %5.1f ns/lookup\n", table_ns);
+  return 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2022 Ryan Daum
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Resident memory of several open editors before and after
+// WebviewPluginView::ReleaseMemory, for the host process and the WebKit
+// processes together.
+//
+// Usage: webview_memory_bench [editors, default 8]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bench_controller.h"
+#include "bench_host.h"
+#include "vstwebview/webview_controller_bindings.h"
+#include "vstwebview/webview_pluginview.h"
+
+namespace {
+
+using vstwebview::bench::BenchHost;
+
+struct Editor {
+  std::unique_ptr<vstwebview::bench::BenchController> controller;
+  std::unique_ptr<vstwebview::WebviewControllerBindings> bindings;
+  vstwebview::WebviewPluginView *view;
+};
+
+void Report(const char *label) {
+  auto helpers = vstwebview::bench::WebKitHelperUsage();
+  size_t host = vstwebview::bench::ResidentBytes();
+  std::printf("%-8s host %7.1f MiB  %d web processes %7.1f MiB  total %7.1f "
+              "MiB\n",
+              label, host / 1048576.0, helpers.processes,
+              helpers.resident_bytes / 1048576.0,
+              (host + helpers.resident_bytes) / 1048576.0);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  int count = argc > 1 ? std::atoi(argv[1]) : 8;
+  BenchHost host;
+  if (!host.has_display()) {
+    std::fprintf(stderr, "no display\n");
+    return 1;
+  }
+  Report("empty");
+
+  // The view keeps a reference to its title.
+  static const std::string title = "memory bench";
+  Steinberg::ViewRect rect(0, 0, 640, 480);
+  std::vector<Editor> editors(count);
+  for (auto &editor : editors) {
+    editor.controller =
+        std::make_unique<vstwebview::bench::BenchController>(256);
+    editor.bindings = std::make_unique<vstwebview::WebviewControllerBindings>(
+        editor.controller.get());
+    editor.view = new vstwebview::WebviewPluginView(
+        editor.controller.get(), title, {editor.bindings.get()}, &rect,
+        vstwebview::bench::ResourceURI("memory.html"));
+    editor.view->SetHiddenReleaseDelay(std::chrono::seconds(0));
+    editor.view->setFrame(&host);
+    editor.view->attached(host.window(),
+                          Steinberg::kPlatformTypeX11EmbedWindowID);
+  }
+  bool ready = host.RunUntil(
+      [&editors]() {
+        for (auto &editor : editors) {
+          if (!editor.view->open_timing().has(
+                  vstwebview::EditorOpenTiming::Phase::kReady)) {
+            return false;
+          }
+        }
+        return true;
+      },
+      std::chrono::seconds(60));
+  if (!ready) {
+    std::fprintf(stderr, "memory.html did not become ready\n");
+    return 1;
+  }
+  host.RunFor(std::chrono::seconds(3));
+  Report("open");
+
+  for (auto &editor : editors) editor.view->ReleaseMemory();
+  host.RunFor(std::chrono::seconds(5));
+  Report("released");
+
+  for (auto &editor : editors) {
+    editor.view->removed();
+    editor.view->release();
+  }
+  host.RunFor(std::chrono::seconds(1));
+  Report("closed");
+  return 0;
+}
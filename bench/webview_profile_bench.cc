@@ -0,0 +1,118 @@
+/*
+ * Copyright 2022 Ryan Daum
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// CPU use of an open editor under each WebviewOptions profile, idle and
+// while values stream in as during a knob drag.
+//
+// Usage: webview_profile_bench [seconds per phase, default 10]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "bench_host.h"
+#include "vstwebview/webview.h"
+
+namespace {
+
+using vstwebview::Webview;
+using vstwebview::WebviewOptions;
+using vstwebview::bench::BenchHost;
+
+struct Sample {
+  double host_seconds;
+  double helper_seconds;
+  std::chrono::steady_clock::time_point when;
+};
+
+Sample Take() {
+  return {vstwebview::bench::ProcessCpuSeconds(),
+          vstwebview::bench::WebKitHelperUsage().cpu_seconds,
+          std::chrono::steady_clock::now()};
+}
+
+void Report(const char *profile, const char *phase, const Sample &start,
+            const Sample &end) {
+  double wall = std::chrono::duration<double>(end.when - start.when).count();
+  std::printf("%-8s %-5s host %6.2f %%  web processes %6.2f %%\n", profile,
+              phase, 100 * (end.host_seconds - start.host_seconds) / wall,
+              100 * (end.helper_seconds - start.helper_seconds) / wall);
+}
+
+void RunProfile(BenchHost *host, const char *name,
+                const WebviewOptions &options,
+                std::chrono::seconds phase) {
+  bool loaded = false;
+  std::unique_ptr<Webview> webview = vstwebview::MakeWebview(
+      options, host, host->window(), [&loaded](Webview *webview) {
+        webview->AddLoadCallback([&loaded](Webview::LoadEvent event) {
+          if (event == Webview::LoadEvent::kFinished) loaded = true;
+        });
+      });
+  webview->SetViewSize(800, 600);
+  webview->Navigate(vstwebview::bench::ResourceURI("editor.html"));
+  if (!host->RunUntil([&loaded]() { return loaded; },
+                      std::chrono::seconds(30))) {
+    std::fprintf(stderr, "%s: editor.html did not load\n", name);
+    std::exit(1);
+  }
+  // Let the first paint and the web process start-up settle.
+  host->RunFor(std::chrono::seconds(2));
+
+  Sample start = Take();
+  host->RunFor(phase);
+  Report(name, "idle", start, Take());
+
+  // One value per display frame, as a host automating a parameter or a
+  // user dragging a knob would produce.
+  double value = 0;
+  auto next = std::chrono::steady_clock::now();
+  int idle_id = webview->AddIdleCallback([&]() {
+    auto now = std::chrono::steady_clock::now();
+    if (now < next) return;
+    next = now + std::chrono::microseconds(16667);
+    value += 0.005;
+    webview->EvalJS("setValue(" + std::to_string(value) + ")",
+                    [](const nlohmann::json &) {});
+  });
+  start = Take();
+  host->RunFor(phase);
+  Report(name, "drag", start, Take());
+  webview->RemoveIdleCallback(idle_id);
+
+  webview->Terminate();
+  webview.reset();
+  host->RunFor(std::chrono::seconds(1));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  std::chrono::seconds phase(argc > 1 ? std::atoi(argv[1]) : 10);
+  BenchHost host;
+  if (!host.has_display()) {
+    std::fprintf(stderr, "no display\n");
+    return 1;
+  }
+  RunProfile(&host, "default", WebviewOptions(), phase);
+  RunProfile(&host, "debug", WebviewOptions::Debug(), phase);
+  // Last: on WebKitGTK the document-viewer cache model is set on the shared
+  // web context and stays in effect for every later webview.
+  RunProfile(&host, "low-cpu", WebviewOptions::LowCPU(), phase);
+  return 0;
+}
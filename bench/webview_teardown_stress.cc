@@ -0,0 +1,98 @@
+/*
+ * Copyright 2022 Ryan Daum
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Opens and closes an editor webview many times and fails if file
+// descriptors or resident memory keep growing, i.e. if closing an editor
+// leaves GTK widgets, signal handlers, timers or WebKit state behind.
+//
+// Usage: webview_teardown_stress [cycles, default 1000]
+// Exits 77 (skipped) when there is no display.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+#include "bench_host.h"
+#include "vstwebview/webview.h"
+
+namespace {
+
+using vstwebview::Webview;
+using vstwebview::bench::BenchHost;
+
+// Cycles before the baseline is taken, so that caches, the web process and
+// GTK's own lazily created state are already in place.
+constexpr int kWarmupCycles = 50;
+constexpr int kMaxFileDescriptorGrowth = 16;
+constexpr size_t kMaxResidentGrowth = 64 << 20;
+
+bool OpenAndClose(BenchHost *host) {
+  bool loaded = false;
+  std::unique_ptr<Webview> webview = vstwebview::MakeWebview(
+      vstwebview::WebviewOptions(), host, host->window(),
+      [&loaded](Webview *webview) {
+        webview->AddLoadCallback([&loaded](Webview::LoadEvent event) {
+          if (event == Webview::LoadEvent::kFinished) loaded = true;
+        });
+      });
+  webview->Navigate(vstwebview::bench::ResourceURI("editor.html"));
+  bool ok = host->RunUntil([&loaded]() { return loaded; },
+                           std::chrono::seconds(10));
+  webview->Terminate();
+  webview.reset();
+  // Let WebKit finish what it does asynchronously on close.
+  host->RunFor(std::chrono::milliseconds(20));
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  int cycles = argc > 1 ? std::atoi(argv[1]) : 1000;
+  BenchHost host;
+  if (!host.has_display()) {
+    std::fprintf(stderr, "no display, skipping\n");
+    return 77;
+  }
+
+  int fds = 0;
+  size_t resident = 0;
+  for (int i = 0; i < cycles; i++) {
+    if (i == kWarmupCycles || (i == 0 && cycles <= kWarmupCycles)) {
+      fds = vstwebview::bench::OpenFileDescriptors();
+      resident = vstwebview::bench::ResidentBytes();
+    }
+    if (!OpenAndClose(&host)) {
+      std::fprintf(stderr, "cycle %d: editor.html did not load\n", i);
+      return 1;
+    }
+  }
+  host.RunFor(std::chrono::seconds(1));
+
+  int fd_growth = vstwebview::bench::OpenFileDescriptors() - fds;
+  long long resident_growth =
+      static_cast<long long>(vstwebview::bench::ResidentBytes()) -
+      static_cast<long long>(resident);
+  std::printf("%d cycles: %+d file descriptors, %+.1f MiB resident\n",
+              cycles, fd_growth, resident_growth / 1048576.0);
+  if (fd_growth > kMaxFileDescriptorGrowth ||
+      resident_growth > static_cast<long long>(kMaxResidentGrowth)) {
+    std::fprintf(stderr, "editor teardown leaks\n");
+    return 1;
+  }
+  return 0;
+}
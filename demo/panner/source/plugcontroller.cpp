@@ -151,9 +151,10 @@ tresult PLUGIN_API PlugController::initialize (FUnknown* context)
 //------------------------------------------------------------------------
 IPlugView* PLUGIN_API PlugController::createView (const char* _name)
 {
-
-  webview_controller_bindings_ =
-      std::make_unique<vstwebview::WebviewControllerBindings>(this);
+  // One set of bindings serves every view the host opens at once.
+  if (!webview_controller_bindings_)
+    webview_controller_bindings_ =
+        std::make_unique<vstwebview::WebviewControllerBindings>(this);
 
   webview_pluginview_ =
       new vstwebview::WebviewPluginView(this,
@@ -186,6 +187,10 @@ tresult PLUGIN_API PlugController::setComponentState (IBStream* state)
 	if (!state)
 		return kResultFalse;
 
+	// Let the UI see the whole state change as one update.
+	vstwebview::WebviewControllerBindings::StateChangeScope state_change (
+	    webview_controller_bindings_.get ());
+
 	IBStreamer streamer (state, kLittleEndian);
 
 	float savedParam1 = 0.f;
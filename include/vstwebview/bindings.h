@@ -23,10 +23,36 @@ class Webview;
 /**
  * Interface for bindings implementations.
  * Each instance is called on webview initialization, to permit the installation
- * of custom JS bindings into the webview.
+ * of custom JS bindings into the webview. An instance may be bound to more than
+ * one webview at a time, e.g. an editor and a detached panel, and gets a
+ * matching Unbind for each.
  */
 class Bindings {
  public:
+  virtual ~Bindings() = default;
+
   virtual void Bind(vstwebview::Webview *webview) = 0;
+
+  /**
+   * Called before the webview is torn down, so that any state tied to it
+   * (subscriptions, dependents, pending callbacks) can be released.
+   */
+  virtual void Unbind(vstwebview::Webview *webview) {}
+
+  /**
+   * Drop caches that can be rebuilt on demand. Called on memory pressure.
+   * Implementations should also release when their last webview is
+   * unbound.
+   */
+  virtual void ReleaseMemory() {}
+
+  /**
+   * Called when 'webview' has been hidden for a while. Bindings shared with
+   * other webviews should drop only what none of their visible views still
+   * uses; the default releases everything, which suits a single view.
+   */
+  virtual void ReleaseMemoryFor(vstwebview::Webview *webview) {
+    ReleaseMemory();
+  }
 };
 }  // namespace vstwebview
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2022 Ryan Daum
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <nlohmann/json.hpp>
+#include <string>
+
+namespace vstwebview {
+
+/**
+ * Timestamps for the milestones between the host attaching the editor and
+ * the page reporting that it is usable. Each milestone records only its first
+ * occurrence after Start(), so reloads do not move the numbers.
+ */
+class EditorOpenTiming {
+ public:
+  enum class Phase {
+    kAttached,          // attachedToParent
+    kWebviewCreated,    // MakeWebview handed back a webview
+    kBindingsInjected,  // the bound document script handed to the engine
+    kNavigate,          // first Navigate issued
+    kLoadStarted,
+    kLoadCommitted,
+    kLoadFinished,
+    kFirstPaint,  // the page's first animation frame after DOMContentLoaded
+    kFirstCall,   // first JS call into a bound function
+    kReady,       // the page called editorReady()
+    kNumPhases
+  };
+
+  static const char *PhaseName(Phase phase);
+
+  // Clears all milestones and records kAttached.
+  void Start();
+  void Mark(Phase phase);
+
+  bool has(Phase phase) const {
+    return times_[static_cast<int>(phase)] !=
+           std::chrono::steady_clock::time_point();
+  }
+
+  /**
+   * Time from kAttached to 'phase', or zero if either is missing.
+   */
+  std::chrono::steady_clock::duration Elapsed(Phase phase) const;
+
+  /**
+   * {"phases": {name: ms since attached}, "total": ms to ready} with missing
+   * phases left out.
+   */
+  nlohmann::json ToJSON() const;
+
+  /**
+   * Called with each milestone as it is first reached, for trace output.
+   */
+  using TraceCallback =
+      std::function<void(Phase phase, std::chrono::steady_clock::duration)>;
+  void set_trace_callback(TraceCallback cb) { trace_ = std::move(cb); }
+
+ private:
+  std::chrono::steady_clock::time_point
+      times_[static_cast<int>(Phase::kNumPhases)];
+  TraceCallback trace_;
+};
+
+}  // namespace vstwebview
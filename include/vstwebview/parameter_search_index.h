@@ -0,0 +1,92 @@
+/*
+ * Copyright 2022 Ryan Daum
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <pluginterfaces/vst/ivstunits.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "vstwebview/parameter_table.h"
+
+namespace vstwebview {
+
+/**
+ * Search index over parameter titles, short titles and unit names, keyed by
+ * ParameterTable slot. Terms of three or more characters are looked up
+ * through a trigram index and match anywhere in a field; shorter terms go
+ * through a sorted word list and match word prefixes. Every term of a query
+ * must match. Results are ranked by where they matched: whole title, title
+ * prefix, title word, then the same for short title and unit name.
+ */
+class ParameterSearchIndex {
+ public:
+  void Build(const ParameterTable &params,
+             Steinberg::Vst::IUnitInfo *unit_info);
+  void Clear();
+
+  /**
+   * Re-read the titles of 'slot'. Returns true if they changed.
+   */
+  bool Update(const ParameterTable &params, int slot);
+
+  /**
+   * Fills 'out' with the slots of matches [offset, offset + count), best
+   * first, and returns the total number of matches. An empty query matches
+   * every parameter in slot order.
+   */
+  int Search(std::string_view query, int offset, int count,
+             std::vector<int> *out);
+
+ private:
+  enum Field { kTitle, kShortTitle, kUnitName, kNumFields };
+  struct Document {
+    std::string fields[kNumFields];
+  };
+  struct Word {
+    std::string text;
+    int32_t slot;
+    bool operator<(const Word &other) const {
+      return text < other.text || (text == other.text && slot < other.slot);
+    }
+  };
+
+  Document MakeDocument(const ParameterTable &params, int slot) const;
+  void Index(int slot, bool sorted_insert);
+  void Deindex(int slot);
+  // Returns the rank of 'term' in 'doc' (lower is better), or -1.
+  static int Score(const Document &doc, std::string_view term);
+
+  std::vector<Document> docs_;
+  std::unordered_map<Steinberg::Vst::UnitID, std::string> unit_names_;
+  std::unordered_map<uint32_t, std::vector<int32_t>> trigrams_;
+  std::vector<Word> words_;
+
+  // Scratch space reused between searches.
+  std::string query_;
+  std::vector<std::string_view> terms_;
+  std::vector<int32_t> candidates_;
+  std::vector<uint32_t> seen_;
+  uint32_t seen_stamp_ = 0;
+  std::vector<std::pair<int, int>> matches_;
+};
+
+}  // namespace vstwebview
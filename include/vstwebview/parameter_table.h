@@ -0,0 +1,109 @@
+/*
+ * Copyright 2022 Ryan Daum
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <public.sdk/source/vst/vsteditcontroller.h>
+
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+namespace vstwebview {
+
+/**
+ * Flat lookup table over an EditController's parameters, built once at bind
+ * time. Sparse ParamIDs map to dense slots through an open-addressing hash,
+ * and per-parameter state is kept in parallel arrays indexed by slot so the
+ * hot paths (edits, change notifications, bulk reads) touch only the columns
+ * they need.
+ */
+class ParameterTable {
+ public:
+  void Build(Steinberg::Vst::EditController *controller);
+  void Clear();
+
+  /**
+   * Returns the dense slot for 'id', or -1 if the parameter is unknown.
+   */
+  int Find(Steinberg::Vst::ParamID id) const {
+    if (hash_.empty()) return -1;
+    for (uint32_t h = Hash(id);; h = (h + 1) & hash_mask_) {
+      const auto &entry = hash_[h];
+      if (entry.slot < 0) return -1;
+      if (entry.id == id) return entry.slot;
+    }
+  }
+
+  int size() const { return static_cast<int>(ids_.size()); }
+
+  Steinberg::Vst::ParamID id(int slot) const { return ids_[slot]; }
+  Steinberg::Vst::Parameter *param(int slot) const { return params_[slot]; }
+  Steinberg::Vst::UnitID unit_id(int slot) const { return unit_ids_[slot]; }
+  Steinberg::int32 step_count(int slot) const { return step_counts_[slot]; }
+
+  // Subscriptions are kept as a mask per parameter with one bit per view, so
+  // several webviews can share the table and a change is serialized once for
+  // all the views that want it.
+  static constexpr int kMaxViews = 32;
+  uint32_t subscribers(int slot) const { return subscribers_[slot]; }
+  bool subscribed(int slot) const { return subscribers_[slot] != 0; }
+  // Returns false if 'view_bit' was already in the requested state.
+  bool SetSubscribed(int slot, uint32_t view_bit, bool subscribed);
+  void ClearSubscriptions(uint32_t view_bit);
+
+  uint64_t version(int slot) const { return versions_[slot]; }
+  void set_version(int slot, uint64_t version) { versions_[slot] = version; }
+
+  /**
+   * Serialize the parameter in 'slot' with its current normalized value. The
+   * static parts (info, range) are serialized once at build time.
+   */
+  nlohmann::json Serialize(int slot) const;
+  void SerializeTo(int slot, std::string *out) const;
+
+  /**
+   * Re-read the static metadata of 'slot', e.g. after its title changed.
+   */
+  void RefreshMetadata(int slot);
+
+ private:
+  struct HashEntry {
+    Steinberg::Vst::ParamID id;
+    int32_t slot;
+  };
+
+  uint32_t Hash(Steinberg::Vst::ParamID id) const {
+    return (id * 0x9E3779B1u) >> hash_shift_;
+  }
+
+  std::vector<HashEntry> hash_;
+  uint32_t hash_mask_ = 0;
+  uint32_t hash_shift_ = 32;
+
+  std::vector<Steinberg::Vst::ParamID> ids_;
+  std::vector<Steinberg::Vst::Parameter *> params_;
+  std::vector<Steinberg::Vst::UnitID> unit_ids_;
+  std::vector<Steinberg::int32> step_counts_;
+  std::vector<uint32_t> subscribers_;
+  std::vector<uint64_t> versions_;
+  std::vector<nlohmann::json> metadata_;
+  // metadata_ dumped without its opening brace, for splicing after the value.
+  std::vector<std::string> metadata_json_;
+};
+
+}  // namespace vstwebview
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2022 Ryan Daum
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <pluginterfaces/vst/ivstunits.h>
+
+#include <cstdint>
+#include <deque>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vstwebview {
+
+/**
+ * Lazily serialised view of a controller's IUnitInfo: the unit tree, the
+ * program lists and their program names. Program names are read in fixed
+ * size pages, so a browser over a large preset bank only pays for the rows
+ * it shows, and the pages either side of the last request are queued for
+ * prefetch from the idle callback.
+ */
+class UnitInfoCache {
+ public:
+  static constexpr int kPageSize = 128;
+
+  void Reset(Steinberg::Vst::IUnitInfo *unit_info);
+
+  int unit_count() const { return static_cast<int>(units_.size()); }
+
+  /**
+   * Serialized units in [offset, offset + count), clamped to the unit count.
+   */
+  nlohmann::json Units(int offset, int count);
+
+  nlohmann::json ProgramLists() const;
+
+  /**
+   * Returns {listId, offset, total, names} for programs in
+   * [offset, offset + count) of 'list_id', or null if the list is unknown.
+   */
+  nlohmann::json ProgramNames(Steinberg::Vst::ProgramListID list_id,
+                              int offset, int count);
+
+  /**
+   * Drop cached names for 'list_id', and re-read its info, e.g. after the
+   * controller reports a program list change.
+   */
+  void InvalidateProgramList(Steinberg::Vst::ProgramListID list_id);
+
+  /**
+   * Read one queued page ahead of time. Returns false if none was pending.
+   */
+  bool Prefetch();
+
+ private:
+  struct ProgramList {
+    Steinberg::Vst::ProgramListID id;
+    std::string name;
+    int program_count;
+  };
+  using Page = std::vector<std::string>;
+
+  static uint64_t PageKey(Steinberg::Vst::ProgramListID list_id, int page) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(list_id)) << 32) |
+           static_cast<uint32_t>(page);
+  }
+  const ProgramList *FindProgramList(
+      Steinberg::Vst::ProgramListID list_id) const;
+  const Page &LoadPage(const ProgramList &list, int page);
+  void QueuePrefetch(const ProgramList &list, int page);
+
+  Steinberg::Vst::IUnitInfo *unit_info_ = nullptr;
+  // Units are serialized on first request; null until then.
+  std::vector<nlohmann::json> units_;
+  std::vector<ProgramList> program_lists_;
+  std::unordered_map<uint64_t, Page> pages_;
+  std::deque<uint64_t> prefetch_;
+};
+
+}  // namespace vstwebview
@@ -16,6 +16,8 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <cstring>
 #include <functional>
 #include <future>
@@ -31,6 +33,29 @@ namespace vstwebview {
 
 using DispatchFunction = std::function<void()>;
 
+/**
+ * What a webview costs: the engine's web process, where the backend can find
+ * it, and the time this process spends pumping events and running bindings
+ * on the webview's behalf. Times are totals since the webview was created.
+ */
+struct ResourceUsage {
+  // 0 if the backend has no separate web process or could not find it.
+  // Backends that must guess which process is the webview's (GTK) may pick
+  // another editor's when several are open.
+  int web_process_id = 0;
+  double web_process_cpu_seconds = 0;
+  // CPU use of the web process since the previous GetResourceUsage().
+  double web_process_cpu_percent = 0;
+  size_t web_process_rss_bytes = 0;
+
+  // Platform event pump and idle callbacks.
+  double pump_seconds = 0;
+  uint64_t idle_ticks = 0;
+  // Native bindings called from JS, including sending their replies.
+  double call_seconds = 0;
+  uint64_t calls = 0;
+};
+
 // Abstract webview parent.
 class Webview {
  public:
@@ -44,6 +69,13 @@ class Webview {
       Webview *webview, int seq, const std::string &, const nlohmann::json &)>;
   void BindFunction(const std::string &name, FunctionBinding f);
 
+  /**
+   * Create a JavaScript function ('name') that invokes native function 'f'
+   * without returning a Promise. No result is sent back, so this suits
+   * high-rate, fire-and-forget streams (e.g. values during a drag).
+   */
+  void BindNotification(const std::string &name, FunctionBinding f);
+
   /**
    * Unbind a previously-bound JavaScript function.
    */
@@ -66,12 +98,20 @@ class Webview {
   virtual void SetViewSize(int width, int height,
                            SizeHint hints = SizeHint::kNone) = 0;
 
+  /*
+   * Set the minimum and maximum size together; a dimension of 0 is left
+   * unbounded. Backends whose platform takes both bounds in one call must
+   * override this so neither replaces the other.
+   */
+  virtual void SetSizeLimits(int min_width, int min_height, int max_width,
+                             int max_height);
+
   virtual std::string ContentRootURI() const = 0;
 
   /**
    * Navigate the webview to a URL.
    */
-  virtual void Navigate(const std::string &url) = 0;
+  void Navigate(const std::string &url);
 
   /*
    * Evaluate a fragment of JS in the webview.
@@ -81,33 +121,181 @@ class Webview {
 
   /*
    * Set a fragment of JS to execute when the webview first loads a document.
+   * Fragments run in the order they were added, after the bound functions
+   * are defined; each is isolated from the others' exceptions, so globals
+   * should be declared on 'window'. Adding a fragment again has no effect.
    */
-  virtual void OnDocumentCreate(const std::string &js) = 0;
+  void OnDocumentCreate(const std::string &js);
+
+  /*
+   * Hand bindings and OnDocumentCreate fragments added since the last call
+   * to the engine now. Navigate and the idle pump do this on their own;
+   * call it directly to know when the script was installed.
+   */
+  void UpdateDocumentScript();
 
   /*
    * Returns the handle for the platform window hosting the webview.
    */
   virtual void *PlatformWindow() const = 0;
 
+  /*
+   * Cover the webview with a static PNG until HidePlaceholder(), so the
+   * editor is not blank while the page loads. Backends without support
+   * ignore both calls.
+   */
+  virtual void ShowPlaceholder(const std::string &png_path) {}
+  virtual void HidePlaceholder() {}
+
+  /*
+   * Asynchronously write what the webview currently shows to 'png_path'.
+   * Backends without support ignore the call.
+   */
+  virtual void SaveSnapshot(const std::string &png_path) {}
+
+  /*
+   * Ask the engine to drop what it can rebuild. WebKitGTK and WKWebView
+   * clear their memory cache of decoded resources; WebView2 suspends the
+   * webview, and only while it is hidden, until it is shown again. None of
+   * them can force a JS garbage collection.
+   */
+  virtual void ReleaseMemory() {}
+
   /*
    * Terminate the webview execution.
    */
   virtual void Terminate() = 0;
 
+  /*
+   * Register a function to be run periodically on the UI thread, from the
+   * platform event pump (roughly once per display frame). Returns an id for
+   * RemoveIdleCallback.
+   */
+  using IdleCallback = std::function<void()>;
+  int AddIdleCallback(IdleCallback cb);
+  void RemoveIdleCallback(int id);
+
+  /*
+   * Register a function to be called as documents load in the webview,
+   * including reloads. kStarted means the previous document (and all of its
+   * JS state) is going away. Returns an id for RemoveLoadCallback.
+   */
+  enum class LoadEvent { kStarted, kCommitted, kFinished };
+  using LoadCallback = std::function<void(LoadEvent)>;
+  int AddLoadCallback(LoadCallback cb);
+  void RemoveLoadCallback(int id);
+
+  /*
+   * Register a function to be called after each JS call into a bound
+   * function has been handled, with the function name and the time spent in
+   * the native binding. Returns an id for RemoveCallObserver.
+   */
+  using CallObserver = std::function<void(
+      const std::string &name, std::chrono::steady_clock::duration elapsed)>;
+  int AddCallObserver(CallObserver cb);
+  void RemoveCallObserver(int id);
+
+  /*
+   * Whether the webview can currently be seen. Backends update this from
+   * platform events (map/unmap, minimise); embedders may add what they know
+   * from the host. Visibility callbacks run on every change.
+   */
+  bool visible() const { return visible_; }
+  void SetVisible(bool visible);
+  using VisibilityCallback = std::function<void(bool visible)>;
+  int AddVisibilityCallback(VisibilityCallback cb);
+  void RemoveVisibilityCallback(int id);
+
+  /*
+   * Sample the webview's resource usage; see ResourceUsage.
+   */
+  virtual ResourceUsage GetResourceUsage();
+
  protected:
   void OnBrowserMessage(const std::string &msg);
+  void OnIdle();
+  void OnLoadEvent(LoadEvent event);
+  // For backends to add time spent in their own event pump.
+  void RecordPumpTime(std::chrono::steady_clock::duration elapsed);
   virtual void DispatchIn(DispatchFunction f) = 0;
+  virtual void DoNavigate(const std::string &url) = 0;
+
+  /*
+   * Replace the script the engine injects at the start of every document.
+   * Bindings and OnDocumentCreate fragments are bundled into this one
+   * script, rebuilt only when they change, so the engine has a single
+   * script to inject and compile per page load however many there are.
+   */
+  virtual void SetDocumentScript(const std::string &js) = 0;
 
  private:
   void ResolveFunctionDispatch(int seq, int status,
                                const nlohmann::json &result);
 
-  std::map<std::string, FunctionBinding> bindings_;
-  ;
+  struct Binding {
+    FunctionBinding fn;
+    // Notifications are fire-and-forget; functions return a Promise.
+    bool notification;
+  };
+  std::map<std::string, Binding> bindings_;
+  std::vector<std::string> document_scripts_;
+  bool document_script_dirty_ = false;
+  std::map<int, IdleCallback> idle_callbacks_;
+  int next_idle_callback_id_ = 1;
+  std::vector<int> idle_ids_;
+  std::map<int, LoadCallback> load_callbacks_;
+  int next_load_callback_id_ = 1;
+  std::map<int, CallObserver> call_observers_;
+  int next_call_observer_id_ = 1;
+  std::vector<int> call_observer_ids_;
+  bool visible_ = true;
+  std::map<int, VisibilityCallback> visibility_callbacks_;
+  int next_visibility_callback_id_ = 1;
+  std::chrono::steady_clock::duration pump_time_{};
+  uint64_t idle_ticks_ = 0;
+  std::chrono::steady_clock::duration call_time_{};
+  uint64_t calls_ = 0;
+};
+
+/**
+ * Engine settings for a new webview. Backends apply what their engine
+ * supports and ignore the rest; a default-constructed value keeps the
+ * engine's own defaults with developer tools off. bench/webview_profile_bench
+ * measures the CPU cost of each profile.
+ */
+struct WebviewOptions {
+  enum class HardwareAcceleration { kDefault, kAlways, kNever, kOnDemand };
+
+  // Developer tools, and console messages written to stdout.
+  bool debug = false;
+  bool smooth_scrolling = true;
+  // Keep previous pages alive for back/forward navigation.
+  bool page_cache = true;
+  // Minimal memory caching, as for a single-document viewer. On WebKitGTK
+  // this applies to the whole web context, i.e. every editor in the process.
+  bool document_viewer_cache = false;
+  HardwareAcceleration hardware_acceleration = HardwareAcceleration::kDefault;
+
+  // Fewest background costs: no smooth scrolling or page cache, the
+  // document-viewer cache model, and compositing only when a page needs it.
+  static WebviewOptions LowCPU() {
+    WebviewOptions options;
+    options.smooth_scrolling = false;
+    options.page_cache = false;
+    options.document_viewer_cache = true;
+    options.hardware_acceleration = HardwareAcceleration::kOnDemand;
+    return options;
+  }
+
+  static WebviewOptions Debug() {
+    WebviewOptions options;
+    options.debug = true;
+    return options;
+  }
 };
 
 using WebviewCreatedCallback = std::function<void(Webview *)>;
-std::unique_ptr<Webview> MakeWebview(bool debug,
+std::unique_ptr<Webview> MakeWebview(const WebviewOptions &options,
                                      Steinberg::IPlugFrame *plug_frame,
                                      void *window,
                                      WebviewCreatedCallback created_cb);
@@ -19,9 +19,15 @@
 #include <public.sdk/source/common/threadchecker.h>
 #include <public.sdk/source/vst/vsteditcontroller.h>
 
+#include <chrono>
 #include <nlohmann/json.hpp>
+#include <unordered_map>
+#include <vector>
 
 #include "vstwebview/bindings.h"
+#include "vstwebview/parameter_search_index.h"
+#include "vstwebview/parameter_table.h"
+#include "vstwebview/unit_info_cache.h"
 #include "vstwebview/webview.h"
 
 using nlohmann::json;
@@ -30,18 +36,87 @@ namespace vstwebview {
 
 /**
  * Implementation of JS bindings for proxying the functionality of the VST3
- * EditController through to the webview.
+ * EditController through to the webview. One instance may be bound to
+ * several webviews at once (an editor and a detached panel, say); they share
+ * the parameter table and caches, each keeps its own subscriptions, and every
+ * change is serialized once for all the views subscribed to it.
  */
 class WebviewControllerBindings : public vstwebview::Bindings {
  public:
   explicit WebviewControllerBindings(
       Steinberg::Vst::EditControllerEx1 *controller);
+  ~WebviewControllerBindings() override;
 
   void Bind(vstwebview::Webview *webview) override;
+  void Unbind(vstwebview::Webview *webview) override;
+  void ReleaseMemory() override;
+  void ReleaseMemoryFor(vstwebview::Webview *webview) override;
+
+  /**
+   * Set the maximum rate (in Hz) at which values streamed from the UI during
+   * an edit gesture are forwarded to the host. The final value of a gesture
+   * is always delivered before endEdit.
+   */
+  void SetEditGestureRate(double hz);
+
+  /**
+   * Bracket bulk state changes (setComponentState, setState, preset loads).
+   * Per-parameter notifications are suppressed inside the bracket, and when
+   * the outermost bracket closes the UI gets a single notification listing
+   * every subscribed parameter whose value actually changed. Brackets nest.
+   * A hidden webview gets no notifications at all; when it is shown again it
+   * gets one catch-up notification for everything that changed meanwhile.
+   */
+  void BeginStateChange();
+  void EndStateChange();
+
+  /**
+   * Drop cached program names for 'list_id' and tell the page through
+   * notifyProgramListChange(listId), if it defines one. Call alongside
+   * EditControllerEx1::notifyProgramListChange.
+   */
+  void InvalidateProgramList(Steinberg::Vst::ProgramListID list_id);
+
+  /**
+   * Re-read parameter titles into the search index and the cached parameter
+   * objects, and pass the IDs that changed to the page's
+   * notifyParameterTitlesChanged(ids), if it defines one. Call alongside
+   * restartComponent(kParamTitlesChanged).
+   */
+  void RefreshParameterTitles();
+
+  /**
+   * Forget cached value display strings, for plugins whose
+   * getParamStringByValue depends on state (tempo sync, units, the current
+   * program). Done automatically by RefreshParameterTitles and at the end of
+   * each state change; call it alongside
+   * restartComponent(kParamValuesChanged) otherwise.
+   */
+  void InvalidateValueStrings();
+
+  // RAII form of Begin/EndStateChange. 'bindings' may be null, for
+  // controllers whose view has not been created yet.
+  class StateChangeScope {
+   public:
+    explicit StateChangeScope(WebviewControllerBindings *bindings)
+        : bindings_(bindings) {
+      if (bindings_) bindings_->BeginStateChange();
+    }
+    ~StateChangeScope() {
+      if (bindings_) bindings_->EndStateChange();
+    }
+    StateChangeScope(const StateChangeScope &) = delete;
+    StateChangeScope &operator=(const StateChangeScope &) = delete;
+
+   private:
+    WebviewControllerBindings *bindings_;
+  };
 
  private:
   void DeclareJSBinding(const std::string &name,
                         vstwebview::Webview::FunctionBinding binding);
+  void DeclareJSNotification(const std::string &name,
+                             vstwebview::Webview::FunctionBinding binding);
 
   using CallbackFn = json (WebviewControllerBindings::*)(
       vstwebview::Webview *webview, const json &);
@@ -54,20 +129,129 @@ class WebviewControllerBindings : public vstwebview::Bindings {
   json SetParameterNormalized(vstwebview::Webview *webview, const json &in);
   json NormalizedParamToPlain(vstwebview::Webview *webview, const json &in);
   json GetParamNormalized(vstwebview::Webview *webview, const json &in);
+  json GetParamsNormalized(vstwebview::Webview *webview, const json &in);
+  json GetParamsSnapshot(vstwebview::Webview *webview, const json &in);
   json BeginEdit(vstwebview::Webview *webview, const json &in);
   json PerformEdit(vstwebview::Webview *webview, const json &in);
   json EndEdit(vstwebview::Webview *webview, const json &in);
   json GetParameterCount(vstwebview::Webview *webview, const json &in);
   json GetSelectedUnit(vstwebview::Webview *webview, const json &in);
   json SelectUnit(vstwebview::Webview *webview, const json &in);
+  json SearchParameters(vstwebview::Webview *webview, const json &in);
+  json GetUnits(vstwebview::Webview *webview, const json &in);
+  json GetProgramLists(vstwebview::Webview *webview, const json &in);
+  json GetProgramNames(vstwebview::Webview *webview, const json &in);
   json SubscribeParameter(vstwebview::Webview *webview, const json &in);
+  json SubscribeUnit(vstwebview::Webview *webview, const json &in);
+  json SubscribeAllParameters(vstwebview::Webview *webview, const json &in);
+  json UnsubscribeParameter(vstwebview::Webview *webview, const json &in);
+  json UnsubscribeAllParameters(vstwebview::Webview *webview, const json &in);
   json DoSendMessage(vstwebview::Webview *webview, const json &in);
+  json GetParamStringByValue(vstwebview::Webview *webview, const json &in);
+  json GetParamValueByString(vstwebview::Webview *webview, const json &in);
+
+  // Value-to-string conversions are cached per parameter and quantised
+  // normalized value. Stepped parameters get a full table per step, filled
+  // in a few parameters at a time from the idle callback.
+  const std::string &ParamValueToString(int index, double value);
+  bool BuildStepStrings(int index);
+  void PrecomputeStepStrings();
+
+  // Throttled edit gestures: beginEditGesture opens the gesture,
+  // editGestureValue streams values without a reply, endEditGesture flushes
+  // the last value and closes it.
+  json BeginEditGesture(vstwebview::Webview *webview, const json &in);
+  json EditGestureValue(vstwebview::Webview *webview, const json &in);
+  json EndEditGesture(vstwebview::Webview *webview, const json &in);
+
+  struct EditGesture {
+    double value = 0;
+    bool pending = false;
+    std::chrono::steady_clock::time_point last_write;
+    // The view that opened the gesture; it is closed if that view goes away
+    // or its page is unloaded.
+    vstwebview::Webview *webview = nullptr;
+  };
+  void WriteEditGestureValue(Steinberg::Vst::ParamID id, EditGesture &gesture);
+  void FlushEditGestures();
+  void EndEditGestures(vstwebview::Webview *webview);
+
+  // Subscription registry. Parameters are addressed by their dense slot in
+  // params_; each is observed once, and a mask per parameter records which
+  // views want its changes, so repeated subscriptions never produce
+  // duplicate notifications.
+  struct View {
+    vstwebview::Webview *webview;
+    uint32_t bit;
+    int idle_callback_id = 0;
+    int visibility_callback_id = 0;
+    int load_callback_id = 0;
+    // Hidden views get nothing; once shown they are sent everything changed
+    // after 'hidden_version' (deferred to the end of any open bracket).
+    bool hidden = false;
+    bool catch_up = false;
+    uint64_t hidden_version = 0;
+  };
+  View *FindView(vstwebview::Webview *webview);
+  uint32_t ViewBit(vstwebview::Webview *webview);
+  void EvalJSAll(const std::string &js);
+
+  void RebuildParameterIndex();
+  void RemoveDependents();
+  bool Subscribe(uint32_t view_bit, int index);
+  bool Unsubscribe(uint32_t view_bit, int index);
+  void UnsubscribeAll(uint32_t view_bit);
+  void OnParameterChanged(Steinberg::Vst::Parameter *param);
+  void OnVisibilityChanged(vstwebview::Webview *webview, bool visible);
+  void OnIdle();
+
+  // Send every parameter changed after 'since' (and, if 'before' is given,
+  // whose value differs from it) to the views in 'view_mask' that subscribed
+  // to it. Each parameter is serialized once however many views get it.
+  void NotifyChanges(uint64_t since, const std::vector<double> *before,
+                     uint32_t view_mask);
+  void FlushCatchUps();
 
   std::unique_ptr<Steinberg::Vst::ThreadChecker> thread_checker_;
   std::vector<std::pair<std::string, vstwebview::Webview::FunctionBinding>>
       bindings_;
+  std::vector<std::pair<std::string, vstwebview::Webview::FunctionBinding>>
+      notifications_;
   std::unique_ptr<Steinberg::IDependent> param_dep_proxy_;
   Steinberg::Vst::EditControllerEx1 *controller_;
+  std::vector<View> views_;
+
+  ParameterTable params_;
+  UnitInfoCache units_;
+  ParameterSearchIndex search_index_;
+  std::vector<int> search_results_;
+  std::string notify_js_;
+  // Serialized changes for NotifyChanges, with the subscriber mask and end
+  // offset of each.
+  std::string changes_json_;
+  std::vector<std::pair<uint32_t, size_t>> changes_;
+
+  // Every observed change stamps the parameter with the next state version,
+  // so the UI can ask for everything that changed since a version it holds.
+  uint64_t state_version_ = 0;
+  std::string epoch_;
+  std::vector<double> packed_values_;
+  std::string packed_out_;
+
+  int state_change_depth_ = 0;
+  uint64_t state_change_version_ = 0;
+  std::vector<double> state_change_values_;
+  std::vector<uint8_t> binary_buffer_;
+
+  std::vector<std::vector<std::string>> step_strings_;
+  std::unordered_map<uint64_t, std::string> value_strings_;
+  size_t step_strings_cursor_ = 0;
+  // Set by ReleaseMemory; idle read-ahead stays off until a view is shown.
+  bool released_ = false;
+
+  std::unordered_map<Steinberg::Vst::ParamID, EditGesture> edit_gestures_;
+  std::chrono::steady_clock::duration edit_gesture_interval_ =
+      std::chrono::milliseconds(33);
 };
 
 }  // namespace vstwebview
\ No newline at end of file
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2022 Ryan Daum
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <pluginterfaces/vst/ivstdataexchange.h>
+#include <public.sdk/source/vst/utility/dataexchange.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "base/source/fobject.h"
+#include "vstwebview/bindings.h"
+
+namespace vstwebview {
+
+class Webview;
+
+/**
+ * Controller-side receiver for the VST3 Data Exchange API, streaming blocks
+ * sent by the processor (e.g. oscilloscope or spectrum data) into the
+ * webview.
+ *
+ * Received blocks are copied into a preallocated single-producer /
+ * single-consumer ring and drained on the webview's idle callback, where
+ * every pending block is delivered in one script as
+ * receiver(typedArray, userContextID). Nothing is allocated per block.
+ * When bound to several webviews the script is built once and evaluated in
+ * each visible one.
+ *
+ * When the host implements IDataExchangeHandler, the controller should
+ * implement IDataExchangeReceiver by forwarding to this object. When it does
+ * not, the SDK's DataExchangeHandler falls back to IMessage, and the
+ * controller should pass its notify() messages to OnMessage().
+ */
+class WebviewDataExchange : public Steinberg::Vst::IDataExchangeReceiver,
+                            public Steinberg::FObject,
+                            public vstwebview::Bindings {
+ public:
+  /**
+   * 'receiver' is the JS function to call; 'element_type' is the typed
+   * array type blocks are decoded as ('f32', 'f64', 'i16', 'i32' or 'u8').
+   * Blocks larger than 'max_block_size' bytes, blocks that are not a whole
+   * number of elements, and blocks arriving while all 'num_slots' slots are
+   * pending are dropped and counted. 'num_slots' is
+   * rounded up to a power of two. A queue opened with larger blocks grows
+   * the slots if no other queue is open; otherwise it is rejected: logged,
+   * counted in rejected_queues(), and its blocks dropped.
+   */
+  WebviewDataExchange(const std::string &receiver,
+                      const std::string &element_type = "f32",
+                      Steinberg::uint32 max_block_size = 16384,
+                      Steinberg::uint32 num_slots = 32);
+
+  // Bindings
+  void Bind(vstwebview::Webview *webview) override;
+  void Unbind(vstwebview::Webview *webview) override;
+  void ReleaseMemory() override;
+
+  // IDataExchangeReceiver
+  void PLUGIN_API queueOpened(Steinberg::Vst::DataExchangeUserContextID id,
+                              Steinberg::uint32 block_size,
+                              Steinberg::TBool &background_thread) override;
+  void PLUGIN_API queueClosed(
+      Steinberg::Vst::DataExchangeUserContextID id) override;
+  void PLUGIN_API onDataExchangeBlocksReceived(
+      Steinberg::Vst::DataExchangeUserContextID id,
+      Steinberg::uint32 num_blocks, Steinberg::Vst::DataExchangeBlock *blocks,
+      Steinberg::TBool background_thread) override;
+
+  /**
+   * Handle the IMessage fallback used when the host lacks the Data Exchange
+   * API. Returns true if the message was a data exchange message.
+   */
+  bool OnMessage(Steinberg::Vst::IMessage *message);
+
+  /**
+   * Queue a block directly, from at most one producer thread at a time.
+   * Returns false if the block was dropped.
+   */
+  bool Push(Steinberg::Vst::DataExchangeUserContextID id, const void *data,
+            Steinberg::uint32 size);
+
+  uint64_t dropped_blocks() const { return dropped_blocks_.load(); }
+  uint32_t rejected_queues() const { return rejected_queues_; }
+
+  DELEGATE_REFCOUNT(Steinberg::FObject)
+  DEFINE_INTERFACES
+  DEF_INTERFACE(Steinberg::Vst::IDataExchangeReceiver)
+  END_DEFINE_INTERFACES(Steinberg::FObject)
+
+ private:
+  void Drain();
+
+  struct Slot {
+    Steinberg::Vst::DataExchangeUserContextID id;
+    Steinberg::uint32 size;
+  };
+
+  std::string receiver_;
+  std::string element_type_;
+  size_t element_size_;
+  Steinberg::uint32 max_block_size_;
+  std::vector<Slot> slots_;
+  uint32_t slot_mask_;
+  std::vector<uint8_t> storage_;
+  std::atomic<uint32_t> read_{0};
+  std::atomic<uint32_t> write_{0};
+  std::atomic<uint64_t> dropped_blocks_{0};
+  // Queues are opened and closed on the UI thread.
+  int open_queues_ = 0;
+  uint32_t rejected_queues_ = 0;
+
+  Steinberg::Vst::DataExchangeReceiverHandler fallback_handler_;
+  struct View {
+    vstwebview::Webview *webview;
+    int idle_callback_id;
+  };
+  std::vector<View> views_;
+  std::string js_;
+};
+
+}  // namespace vstwebview
@@ -14,50 +14,212 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include <public.sdk/source/vst/vsteditcontroller.h>
 
 #include <nlohmann/json.hpp>
 
+#include "vstwebview/bindings.h"
+
 using nlohmann::json;
 
 namespace vstwebview {
 
 class Webview;
 
-class WebviewMessageListener {
+// Delivers IMessages from the processor to JS receivers. Pass it to the
+// plugin view with the other bindings; it may be bound to several webviews
+// at once (an editor and a detached panel) and keeps its subscriptions across
+// editor close and reopen. Native subscriptions are delivered to every view,
+// page subscriptions only to the page that made them. Messages that arrive
+// while no visible webview is bound are held like those for a hidden page.
+class WebviewMessageListener : public vstwebview::Bindings {
 public:
-  explicit WebviewMessageListener(vstwebview::Webview *webview)
-      : webview_(webview) {}
+  WebviewMessageListener() = default;
+  ~WebviewMessageListener() override;
+
+  void Bind(vstwebview::Webview *webview) override;
+  void Unbind(vstwebview::Webview *webview) override;
 
   struct MessageAttribute {
     std::string name;
-    enum class Type { INT, FLOAT, STRING, BINARY };
+    // Binary attributes reach JS as typed arrays over the raw bytes: BINARY
+    // as a Float64Array (as it always carried doubles), the BINARY_* forms as
+    // the matching element type, leaving out any bytes past the last whole
+    // element. Strings may be of any length.
+    enum class Type {
+      INT,
+      FLOAT,
+      STRING,
+      BINARY,
+      BINARY_F32,
+      BINARY_F64,
+      BINARY_I16,
+      BINARY_I32,
+      BINARY_U8
+    };
     Type type;
   };
 
+  // How messages for a subscription are delivered. ALL evaluates JS for
+  // every message as it arrives. LATEST holds the newest message natively and
+  // delivers it on the next UI tick, replacing any still pending. MAX_RATE
+  // does the same but delivers at most max_hz times a second. A hidden
+  // webview gets nothing; once shown it is sent the newest message of each
+  // ID that arrived meanwhile, as if every mode were LATEST.
+  struct DeliveryPolicy {
+    enum class Mode { ALL, LATEST, MAX_RATE };
+    Mode mode = Mode::ALL;
+    double max_hz = 0;
+  };
+
+  // Per-subscription counters, for tuning processor send rates. 'merged'
+  // counts messages superseded by a newer one under LATEST, 'dropped' those
+  // superseded under MAX_RATE.
+  struct DeliveryStats {
+    uint64_t received = 0;
+    uint64_t delivered = 0;
+    uint64_t merged = 0;
+    uint64_t dropped = 0;
+  };
+
+  /**
+   * Subscribe JS function 'receiver' to messages with 'message_id'. Several
+   * receivers may subscribe to the same ID: each message is serialized once
+   * and handed to all of them in a single script. Attribute lists of all
+   * receivers of an ID are merged, and the most recent policy applies.
+   *
+   * Pages can also subscribe themselves with
+   * subscribeMessage(receiver, messageId, [{name, type}], {mode, maxHz}) and
+   * unsubscribeMessage(receiver, messageId); those subscriptions are dropped
+   * automatically when the page reloads.
+   *
+   * Every message advances a stream version. replayMessages(sinceVersion)
+   * re-delivers the newest message of each ID received after that version
+   * and resolves to the current version, so a reloaded page can catch up.
+   */
+  void Subscribe(const std::string &receiver, const std::string &message_id,
+                 const std::vector<MessageAttribute> &attributes,
+                 const DeliveryPolicy &policy);
+  // Subscribes with the default policy, ALL. (DeliveryPolicy's member
+  // initializers cannot serve a default argument inside this class.)
   void Subscribe(const std::string &receiver, const std::string &message_id,
                  const std::vector<MessageAttribute> &attributes);
 
+  void Unsubscribe(const std::string &receiver, const std::string &message_id);
+
+  // Remove 'receiver' from every message ID.
+  void Unsubscribe(const std::string &receiver);
+
   Steinberg::tresult Notify(Steinberg::Vst::IMessage *message);
 
+  DeliveryStats GetStats(const std::string &message_id) const;
+
 private:
-  struct MessageDescriptor {
+  // A subscription's attribute list compiled at Subscribe time: attribute
+  // IDs, pre-escaped key fragments and the message prefix are built once, so
+  // serializing a message is a straight walk appending into a reused buffer.
+  struct CompiledAttribute {
+    std::string id;
+    std::string key;  // ,"name":
+    MessageAttribute::Type type;
+  };
+
+  struct MessageSerializer {
     std::string message_id;
-    std::vector<MessageAttribute> attributes;
+    size_t id_hash;
+    std::string prefix;  // {"messageId":"..."
+    std::vector<CompiledAttribute> attributes;
   };
 
-  struct MessageSubscription {
-    MessageDescriptor descriptor;
-    std::string notify_function;
+  struct Receiver {
+    std::string function;
+    // The page that subscribed itself, so the receiver is dropped when it
+    // reloads; null for native subscriptions, which reach every view.
+    vstwebview::Webview *page;
+  };
+
+  // The call wrapper around the serialized message for the receivers one
+  // view has: "f(" for a single receiver, "(function(m){f(m);g(m);})(" for
+  // several.
+  struct ViewCall {
+    vstwebview::Webview *webview;
+    std::string prefix;
   };
 
-  json SerializeMessage(Steinberg::Vst::IMessage *message,
-                        const MessageDescriptor &descriptor);
+  // All receivers of one message ID. The call wrappers are rebuilt when
+  // receivers or views change; views without receivers have none.
+  struct MessageSubscription {
+    MessageSerializer serializer;
+    std::vector<MessageAttribute> attributes;
+    std::vector<Receiver> receivers;
+    std::vector<ViewCall> calls;
+    DeliveryPolicy policy;
+    DeliveryStats stats;
+    Steinberg::IPtr<Steinberg::Vst::IMessage> pending;
+    std::chrono::steady_clock::time_point last_delivery;
+    // Newest message and the stream version it arrived at, for replay to a
+    // reloaded page.
+    Steinberg::IPtr<Steinberg::Vst::IMessage> last_message;
+    uint64_t version = 0;
+  };
 
-  std::unordered_map<std::string, MessageSubscription> subscriptions_;
-  vstwebview::Webview *webview_;
+  static MessageSerializer Compile(
+      const std::string &message_id,
+      const std::vector<MessageAttribute> &attributes);
+  MessageSubscription *FindSubscription(const char *message_id);
+  void AddReceiver(const std::string &receiver, const std::string &message_id,
+                   const std::vector<MessageAttribute> &attributes,
+                   const DeliveryPolicy &policy, vstwebview::Webview *page);
+  // Removes receivers matching 'predicate' from 'message_id' (or from every
+  // ID if null), dropping subscriptions left without receivers.
+  void RemoveReceivers(const char *message_id,
+                       const std::function<bool(const Receiver &)> &predicate);
+  void UpdateCalls(MessageSubscription &subscription);
+
+  json SubscribeFromPage(vstwebview::Webview *webview, const json &in);
+  json UnsubscribeFromPage(vstwebview::Webview *webview, const json &in);
+  json ReplayMessages(vstwebview::Webview *webview, const json &in);
+  // Serializes 'message' once and evaluates it in every visible view, or
+  // only in 'target' if given.
+  void Deliver(MessageSubscription &subscription,
+               Steinberg::Vst::IMessage *message,
+               vstwebview::Webview *target = nullptr);
+  void FlushPending();
+  void OnVisibilityChanged(vstwebview::Webview *webview, bool visible);
+  bool AnyViewVisible() const;
+
+  // Writes the message as a JS object expression (binary attributes are
+  // decoded into typed arrays in place, so this is not plain JSON).
+  void SerializeMessage(Steinberg::Vst::IMessage *message,
+                        const MessageSerializer &serializer, std::string *out);
+  bool GetString(Steinberg::Vst::IAttributeList *attributes, const char *name,
+                 std::string *out);
+
+  // Few subscriptions are expected, so a flat list matched by hash and then
+  // by string beats building a std::string key for every message.
+  std::vector<MessageSubscription> subscriptions_;
+  struct View {
+    vstwebview::Webview *webview;
+    int idle_callback_id = 0;
+    int load_callback_id = 0;
+    int visibility_callback_id = 0;
+    // Stream version the view was last brought up to date at; once shown
+    // after being hidden it is sent what arrived since.
+    uint64_t hidden_version = 0;
+  };
+  std::vector<View> views_;
+  uint64_t message_version_ = 0;
+  std::u16string string_buffer_;
+  std::string string_value_;
+  std::string message_js_;
+  std::string js_;
 };
 
 }  // namespace vstwebview
\ No newline at end of file
@@ -18,12 +18,14 @@
 
 #include <public.sdk/source/vst/vsteditcontroller.h>
 
+#include <chrono>
 #include <deque>
 #include <functional>
 #include <mutex>
 #include <thread>
 
 #include "vstwebview/bindings.h"
+#include "vstwebview/editor_open_timing.h"
 #include "vstwebview/webview.h"
 
 namespace vstwebview {
@@ -52,10 +54,100 @@ class WebviewPluginView : public Steinberg::Vst::EditorView {
   Steinberg::tresult onFocus(Steinberg::TBool a_bool) override;
 
   Steinberg::tresult canResize() override;
+  Steinberg::tresult checkSizeConstraint(Steinberg::ViewRect *rect) override;
   Steinberg::tresult onSize(Steinberg::ViewRect *newSize) override;
 
+  /**
+   * Let the host resize the editor within these bounds; a bound of 0 is
+   * left open. Without limits the editor keeps its initial size.
+   */
+  void SetSizeLimits(int min_width, int min_height, int max_width = 0,
+                     int max_height = 0);
+
+  /**
+   * Milestones of the most recent editor open. The page marks itself usable
+   * by calling editorReady(); getEditorOpenTiming() returns the same data to
+   * JS. Set a trace callback on it to log milestones as they happen.
+   */
+  EditorOpenTiming &open_timing() { return open_timing_; }
+
+  /**
+   * Engine settings for webviews created from now on. Defaults to
+   * WebviewOptions::Debug() in DEVELOPMENT builds and to the engine defaults
+   * otherwise.
+   */
+  void SetWebviewOptions(const WebviewOptions &options) {
+    webview_options_ = options;
+  }
+
+  /**
+   * Sample the open editor's resource usage. Returns false if no webview is
+   * open. Pages can read the same through getResourceUsage(), or call
+   * vstwebview.showResourceOverlay() for a live readout.
+   */
+  bool GetResourceUsage(ResourceUsage *usage);
+
+  /**
+   * Release memory held for the editor: the engine's caches (see
+   * Webview::ReleaseMemory), the page's (handlers registered with
+   * vstwebview.onMemoryPressure drop references for the engine's own GC to
+   * reclaim later) and the bindings' native caches.
+   * Call it when the host or OS reports memory pressure. An editor hidden
+   * for the hidden-release delay releases its engine and page by itself,
+   * and the bindings release through Bindings::ReleaseMemoryFor, so caches
+   * shared with a visible view stay. Bindings release their own caches when
+   * their last view closes. A delay of zero disables the hidden trigger.
+   */
+  void ReleaseMemory();
+  void SetHiddenReleaseDelay(std::chrono::steady_clock::duration delay) {
+    hidden_release_delay_ = delay;
+  }
+
+  /**
+   * Show 'png_path' (e.g. the plugin's _snapshot.png) over the editor until
+   * the page first paints. With a 'cache_path', the page is captured there
+   * when it calls editorReady(), and that capture is shown on later opens.
+   */
+  void SetPlaceholder(const std::string &png_path,
+                      const std::string &cache_path = {});
+
  private:
+  // Host resizes arrive per mouse move during a drag. onSize only records
+  // the latest size; the idle callback applies it at most once per tick,
+  // and once the size has held for a tick tells the page through
+  // notifyViewResize(width, height), if it defines one.
+  void ApplyPendingSize(vstwebview::Webview *webview);
+  void ApplySizeLimits(vstwebview::Webview *webview);
+  // The engine's and the page's share of ReleaseMemory.
+  void ReleasePageMemory(vstwebview::Webview *webview);
+  void CheckHiddenRelease(vstwebview::Webview *webview);
+
   std::mutex webview_mutex_;
+  bool resizable_ = false;
+  int min_width_ = 0;
+  int min_height_ = 0;
+  int max_width_ = 0;
+  int max_height_ = 0;
+  int pending_width_ = 0;
+  int pending_height_ = 0;
+  int applied_width_ = 0;
+  int applied_height_ = 0;
+  bool resize_notify_pending_ = false;
+  int idle_callback_id_ = 0;
+
+  WebviewOptions webview_options_;
+  std::string placeholder_path_;
+  std::string placeholder_cache_path_;
+
+  EditorOpenTiming open_timing_;
+  int load_callback_id_ = 0;
+  int call_observer_id_ = 0;
+  int visibility_callback_id_ = 0;
+
+  std::chrono::steady_clock::duration hidden_release_delay_ =
+      std::chrono::seconds(30);
+  std::chrono::steady_clock::time_point hidden_since_;
+  bool hidden_released_ = false;
   const std::string &title_;
   std::unique_ptr<vstwebview::Webview> webview_handle_;
   std::vector<vstwebview::Bindings *> bindings_;
@@ -0,0 +1,85 @@
+// Copyright 2022 Ryan Daum
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vstwebview/binary_encoding.h"
+
+namespace vstwebview {
+
+namespace {
+
+constexpr char kAlphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+int DecodeChar(char c) {
+  if (c >= 'A' && c <= 'Z') return c - 'A';
+  if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+  if (c >= '0' && c <= '9') return c - '0' + 52;
+  if (c == '+') return 62;
+  if (c == '/') return 63;
+  return -1;
+}
+
+}  // namespace
+
+size_t BinaryElementSize(std::string_view type) {
+  if (type == "f64") return 8;
+  if (type == "f32" || type == "i32") return 4;
+  if (type == "i16") return 2;
+  return 1;
+}
+
+void Base64Encode(const void *data, size_t size, std::string *out) {
+  auto *bytes = static_cast<const uint8_t *>(data);
+  size_t start = out->size();
+  out->resize(start + (size + 2) / 3 * 4);
+  char *dst = out->data() + start;
+
+  size_t i = 0;
+  for (; i + 2 < size; i += 3) {
+    uint32_t n = (bytes[i] << 16) | (bytes[i + 1] << 8) | bytes[i + 2];
+    *dst++ = kAlphabet[(n >> 18) & 63];
+    *dst++ = kAlphabet[(n >> 12) & 63];
+    *dst++ = kAlphabet[(n >> 6) & 63];
+    *dst++ = kAlphabet[n & 63];
+  }
+  if (i < size) {
+    uint32_t n = bytes[i] << 16;
+    if (i + 1 < size) n |= bytes[i + 1] << 8;
+    *dst++ = kAlphabet[(n >> 18) & 63];
+    *dst++ = kAlphabet[(n >> 12) & 63];
+    *dst++ = i + 1 < size ? kAlphabet[(n >> 6) & 63] : '=';
+    *dst++ = '=';
+  }
+}
+
+bool Base64Decode(std::string_view in, std::vector<uint8_t> *out) {
+  out->clear();
+  out->reserve(in.size() / 4 * 3);
+  uint32_t n = 0;
+  int bits = 0;
+  for (char c : in) {
+    if (c == '=') break;
+    int v = DecodeChar(c);
+    if (v < 0) return false;
+    n = (n << 6) | v;
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      out->push_back(static_cast<uint8_t>((n >> bits) & 0xff));
+    }
+  }
+  return true;
+}
+
+}  // namespace vstwebview
@@ -0,0 +1,73 @@
+// Copyright 2022 Ryan Daum
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vstwebview {
+
+// Script messages and EvalJS only carry text, so binary payloads travel as
+// base64 and are turned back into typed arrays by the JS runtime below.
+
+// Appends the base64 encoding of 'size' bytes at 'data' to 'out'.
+void Base64Encode(const void *data, size_t size, std::string *out);
+
+// Decodes base64 'in' into 'out' (replacing its contents). Returns false on
+// malformed input.
+bool Base64Decode(std::string_view in, std::vector<uint8_t> *out);
+
+// Size in bytes of one element of typed array type 'type' ('f32', 'f64',
+// 'i16', 'i32' or 'u8'); 1 for unknown types, which decode as 'u8'.
+size_t BinaryElementSize(std::string_view type);
+
+// JS helpers installed into the page: vstwebview.decodeBinary(b64, type)
+// returns a typed array ('f32', 'f64', 'i16', 'i32' or 'u8') over the
+// decoded bytes, and vstwebview.encodeBinary(bufferOrView) the reverse.
+// Trailing bytes that do not fill a whole element are left out of the
+// array rather than making the typed array constructor throw.
+constexpr char kBinaryRuntimeJS[] = R"(
+(function() {
+  var vw = window.vstwebview = window.vstwebview || {};
+  if (vw.decodeBinary) return;
+  var types = {
+    f32: Float32Array, f64: Float64Array, i16: Int16Array,
+    i32: Int32Array, u8: Uint8Array,
+  };
+  vw.decodeBinary = function(b64, type) {
+    var bin = atob(b64);
+    var bytes = new Uint8Array(bin.length);
+    for (var i = 0; i < bin.length; i++) bytes[i] = bin.charCodeAt(i);
+    var Type = types[type] || Uint8Array;
+    return new Type(bytes.buffer, 0,
+                    Math.floor(bytes.length / Type.BYTES_PER_ELEMENT));
+  };
+  vw.encodeBinary = function(data) {
+    var bytes = data instanceof ArrayBuffer ?
+        new Uint8Array(data) :
+        new Uint8Array(data.buffer, data.byteOffset, data.byteLength);
+    var chunks = [];
+    for (var i = 0; i < bytes.length; i += 0x8000) {
+      chunks.push(String.fromCharCode.apply(null, bytes.subarray(i, i + 0x8000)));
+    }
+    return btoa(chunks.join(''));
+  };
+})();
+)";
+
+}  // namespace vstwebview
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2022 Ryan Daum
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vstwebview/editor_open_timing.h"
+
+namespace vstwebview {
+
+namespace {
+
+double ToMillis(std::chrono::steady_clock::duration d) {
+  return std::chrono::duration<double, std::milli>(d).count();
+}
+
+}  // namespace
+
+const char *EditorOpenTiming::PhaseName(Phase phase) {
+  switch (phase) {
+    case Phase::kAttached:
+      return "attached";
+    case Phase::kWebviewCreated:
+      return "webviewCreated";
+    case Phase::kBindingsInjected:
+      return "bindingsInjected";
+    case Phase::kNavigate:
+      return "navigate";
+    case Phase::kLoadStarted:
+      return "loadStarted";
+    case Phase::kLoadCommitted:
+      return "loadCommitted";
+    case Phase::kLoadFinished:
+      return "loadFinished";
+    case Phase::kFirstPaint:
+      return "firstPaint";
+    case Phase::kFirstCall:
+      return "firstCall";
+    case Phase::kReady:
+      return "ready";
+    default:
+      return "";
+  }
+}
+
+void EditorOpenTiming::Start() {
+  for (auto &time : times_) time = {};
+  Mark(Phase::kAttached);
+}
+
+void EditorOpenTiming::Mark(Phase phase) {
+  if (has(phase) || (!has(Phase::kAttached) && phase != Phase::kAttached))
+    return;
+  times_[static_cast<int>(phase)] = std::chrono::steady_clock::now();
+  if (trace_) trace_(phase, Elapsed(phase));
+}
+
+std::chrono::steady_clock::duration EditorOpenTiming::Elapsed(
+    Phase phase) const {
+  if (!has(phase) || !has(Phase::kAttached)) return {};
+  return times_[static_cast<int>(phase)] -
+         times_[static_cast<int>(Phase::kAttached)];
+}
+
+nlohmann::json EditorOpenTiming::ToJSON() const {
+  nlohmann::json phases = nlohmann::json::object();
+  for (int i = 0; i < static_cast<int>(Phase::kNumPhases); i++) {
+    auto phase = static_cast<Phase>(i);
+    if (has(phase)) phases[PhaseName(phase)] = ToMillis(Elapsed(phase));
+  }
+  nlohmann::json out = {{"phases", std::move(phases)}};
+  if (has(Phase::kReady)) out["total"] = ToMillis(Elapsed(Phase::kReady));
+  return out;
+}
+
+}  // namespace vstwebview
@@ -1,9 +1,19 @@
 #include <JavaScriptCore/JavaScript.h>
 #include <X11/X.h>
 
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <set>
+#include <string>
 #include <thread>
+#include <vector>
 #define GNU_SOURCE
+#include <dirent.h>
 #include <dlfcn.h>
+#include <unistd.h>
 #include <gtk-3.0/gtk/gtk.h>
 #include <gtk-3.0/gtk/gtkx.h>
 #include <webkit2/webkit2.h>
@@ -15,12 +25,79 @@ static unsigned int kAddressMarker = 0xcafebabe;
 
 namespace vstwebview {
 
+namespace {
+
+struct ProcessStat {
+  int parent_pid = 0;
+  std::string name;
+  uint64_t cpu_ticks = 0;  // user + system
+  uint64_t rss_pages = 0;
+};
+
+bool ReadProcessStat(int pid, ProcessStat *stat) {
+  char path[64];
+  std::snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+  FILE *file = std::fopen(path, "r");
+  if (!file) return false;
+  char buffer[1024];
+  size_t len = std::fread(buffer, 1, sizeof(buffer) - 1, file);
+  std::fclose(file);
+  buffer[len] = 0;
+
+  // The command name is parenthesised and may itself contain spaces or
+  // parentheses, so parse the numeric fields from the last ')'.
+  char *open = std::strchr(buffer, '(');
+  char *close = std::strrchr(buffer, ')');
+  if (!open || !close || close < open) return false;
+  stat->name.assign(open + 1, close);
+  unsigned long long utime, stime;
+  long long rss;
+  if (std::sscanf(close + 2,
+                  "%*c %d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu "
+                  "%*d %*d %*d %*d %*d %*d %*u %*u %lld",
+                  &stat->parent_pid, &utime, &stime, &rss) != 4) {
+    return false;
+  }
+  stat->cpu_ticks = utime + stime;
+  stat->rss_pages = rss > 0 ? static_cast<uint64_t>(rss) : 0;
+  return true;
+}
+
+// WebKit web processes started by this (host) process. The kernel truncates
+// process names to 15 characters.
+std::set<int> ChildWebProcesses() {
+  std::set<int> pids;
+  DIR *proc = opendir("/proc");
+  if (!proc) return pids;
+  int self = getpid();
+  ProcessStat stat;
+  while (dirent *entry = readdir(proc)) {
+    int pid = std::atoi(entry->d_name);
+    if (pid <= 0 || !ReadProcessStat(pid, &stat)) continue;
+    if (stat.parent_pid == self &&
+        stat.name.compare(0, 13, "WebKitWebProc") == 0) {
+      pids.insert(pid);
+    }
+  }
+  closedir(proc);
+  return pids;
+}
+
+// Web processes already attributed to a webview in this process.
+std::set<int> &ClaimedWebProcesses() {
+  static std::set<int> claimed;
+  return claimed;
+}
+
+}  // namespace
+
 class WebviewWebkitGTK : public Webview,
                          public Steinberg::Linux::ITimerHandler,
                          public Steinberg::FObject {
  public:
-  WebviewWebkitGTK(bool debug, Steinberg::IPlugFrame *plug_frame,
-                   Window x11Parent, WebviewCreatedCallback created_callback) {
+  WebviewWebkitGTK(const WebviewOptions &options,
+                   Steinberg::IPlugFrame *plug_frame, Window x11Parent,
+                   WebviewCreatedCallback created_callback) {
     // On linux the IPlugFrame is also a "run loop" we can use to schedule
     // timers and file-descriptor triggered events.
     run_loop_ = plug_frame;
@@ -35,12 +112,16 @@ class WebviewWebkitGTK : public Webview,
                      }),
                      this);
 
-    MakeWebView(debug);
+    MakeWebView(options);
     OnDocumentCreate(
         "window.external={invoke:function(s){window.webkit.messageHandlers."
         "external.postMessage(s);}}");
 
-    gtk_container_add(GTK_CONTAINER(window_), webview_);
+    // The overlay lets a placeholder image sit over the webview while it
+    // loads; the webview stays mapped underneath so it still renders.
+    overlay_ = gtk_overlay_new();
+    gtk_container_add(GTK_CONTAINER(overlay_), webview_);
+    gtk_container_add(GTK_CONTAINER(window_), overlay_);
     gtk_widget_grab_focus(webview_);
     gtk_widget_show_all(window_);
 
@@ -50,6 +131,11 @@ class WebviewWebkitGTK : public Webview,
     run_loop_->registerTimer(this, 16);
   }
 
+  ~WebviewWebkitGTK() override {
+    Terminate();
+    g_object_unref(snapshot_cancellable_);
+  }
+
   std::string ContentRootURI() const override {
     std::string resPath;
     Dl_info info;
@@ -63,16 +149,6 @@ class WebviewWebkitGTK : public Webview,
     return "";
   }
 
-  void OnDocumentCreate(const std::string &js) override {
-    WebKitUserContentManager *manager =
-        webkit_web_view_get_user_content_manager(WEBKIT_WEB_VIEW(webview_));
-    webkit_user_content_manager_add_script(
-        manager,
-        webkit_user_script_new(js.c_str(), WEBKIT_USER_CONTENT_INJECT_TOP_FRAME,
-                               WEBKIT_USER_SCRIPT_INJECT_AT_DOCUMENT_START,
-                               nullptr, nullptr));
-  }
-
   void SetTitle(const std::string &title) override {
     gtk_window_set_title(GTK_WINDOW(window_), title.c_str());
   }
@@ -83,28 +159,142 @@ class WebviewWebkitGTK : public Webview,
       gtk_window_resize(GTK_WINDOW(window_), width, height);
     } else if (hints == SizeHint::kFixed) {
       gtk_widget_set_size_request(window_, width, height);
+    } else if (hints == SizeHint::kMin) {
+      SetSizeLimits(width, height, max_width_, max_height_);
     } else {
-      GdkGeometry g;
-      g.min_width = g.max_width = width;
-      g.min_height = g.max_height = height;
-      GdkWindowHints h =
-          (hints == SizeHint::kMin ? GDK_HINT_MIN_SIZE : GDK_HINT_MAX_SIZE);
-      // This defines either MIN_SIZE, or MAX_SIZE, but not both:
-      gtk_window_set_geometry_hints(GTK_WINDOW(window_), nullptr, &g, h);
+      SetSizeLimits(min_width_, min_height_, width, height);
     }
   }
 
-  void Navigate(const std::string &url) override {
-    webkit_web_view_load_uri(WEBKIT_WEB_VIEW(webview_), url.c_str());
+  void SetSizeLimits(int min_width, int min_height, int max_width,
+                     int max_height) override {
+    // Each geometry hints call replaces the previous one, so both bounds
+    // are kept and always sent together.
+    min_width_ = min_width;
+    min_height_ = min_height;
+    max_width_ = max_width;
+    max_height_ = max_height;
+    GdkGeometry g = {};
+    int h = 0;
+    if (min_width > 0 || min_height > 0) {
+      g.min_width = min_width;
+      g.min_height = min_height;
+      h |= GDK_HINT_MIN_SIZE;
+    }
+    if (max_width > 0 && max_height > 0) {
+      g.max_width = max_width;
+      g.max_height = max_height;
+      h |= GDK_HINT_MAX_SIZE;
+    }
+    gtk_window_set_geometry_hints(GTK_WINDOW(window_), nullptr, &g,
+                                  static_cast<GdkWindowHints>(h));
   }
 
   void EvalJS(const std::string &js, ResultCallback rs) override {
+    if (!webview_) return;
     webkit_web_view_run_javascript(WEBKIT_WEB_VIEW(webview_), js.c_str(),
                                    nullptr, nullptr, nullptr);
   }
 
+  void ShowPlaceholder(const std::string &png_path) override {
+    HidePlaceholder();
+    GError *error = nullptr;
+    GdkPixbuf *pixbuf = gdk_pixbuf_new_from_file(png_path.c_str(), &error);
+    if (!pixbuf) {
+      g_clear_error(&error);
+      return;
+    }
+    placeholder_ = gtk_image_new_from_pixbuf(pixbuf);
+    g_object_unref(pixbuf);
+    gtk_widget_set_halign(placeholder_, GTK_ALIGN_START);
+    gtk_widget_set_valign(placeholder_, GTK_ALIGN_START);
+    gtk_overlay_add_overlay(GTK_OVERLAY(overlay_), placeholder_);
+    gtk_widget_show(placeholder_);
+  }
+
+  void HidePlaceholder() override {
+    if (!placeholder_) return;
+    gtk_widget_destroy(placeholder_);
+    placeholder_ = nullptr;
+  }
+
+  void SaveSnapshot(const std::string &png_path) override {
+    webkit_web_view_get_snapshot(
+        WEBKIT_WEB_VIEW(webview_), WEBKIT_SNAPSHOT_REGION_VISIBLE,
+        WEBKIT_SNAPSHOT_OPTIONS_NONE, snapshot_cancellable_,
+        +[](GObject *source, GAsyncResult *result, gpointer arg) {
+          // Only the path is owned here; the view may already be gone if
+          // the snapshot was cancelled.
+          std::unique_ptr<std::string> path(static_cast<std::string *>(arg));
+          cairo_surface_t *surface = webkit_web_view_get_snapshot_finish(
+              WEBKIT_WEB_VIEW(source), result, nullptr);
+          if (!surface) return;
+          cairo_surface_write_to_png(surface, path->c_str());
+          cairo_surface_destroy(surface);
+        },
+        new std::string(png_path));
+  }
+
+  ResourceUsage GetResourceUsage() override {
+    ResourceUsage usage = Webview::GetResourceUsage();
+    ProcessStat stat;
+    if (web_process_id_ == 0 || !ReadProcessStat(web_process_id_, &stat)) {
+      FindWebProcess();
+      if (web_process_id_ == 0 || !ReadProcessStat(web_process_id_, &stat))
+        return usage;
+    }
+
+    static const double ticks_per_second = sysconf(_SC_CLK_TCK);
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    auto now = std::chrono::steady_clock::now();
+    usage.web_process_id = web_process_id_;
+    usage.web_process_cpu_seconds = stat.cpu_ticks / ticks_per_second;
+    usage.web_process_rss_bytes = stat.rss_pages * page_size;
+    if (last_sample_ticks_ > 0 && stat.cpu_ticks >= last_sample_ticks_) {
+      double wall = std::chrono::duration<double>(now - last_sample_).count();
+      if (wall > 0) {
+        usage.web_process_cpu_percent =
+            100.0 * (stat.cpu_ticks - last_sample_ticks_) / ticks_per_second /
+            wall;
+      }
+    }
+    last_sample_ticks_ = stat.cpu_ticks;
+    last_sample_ = now;
+    return usage;
+  }
+
+  void ReleaseMemory() override {
+    if (!webview_) return;
+    webkit_website_data_manager_clear(
+        webkit_web_view_get_website_data_manager(WEBKIT_WEB_VIEW(webview_)),
+        WEBKIT_WEBSITE_DATA_MEMORY_CACHE, 0, nullptr, nullptr, nullptr);
+  }
+
   void *PlatformWindow() const override { return window_; }
-  void Terminate() override { gtk_main_quit(); }
+  void Terminate() override {
+    // No gtk_main is running (the host's run loop drives GTK through
+    // onTimer), so there is nothing to quit. Instead release everything this
+    // view registered, so repeated open/close cycles do not accumulate.
+    if (!window_) return;
+    ReleaseWebProcess();
+    g_cancellable_cancel(snapshot_cancellable_);
+    run_loop_->unregisterTimer(this);
+
+    WebKitUserContentManager *manager =
+        webkit_web_view_get_user_content_manager(WEBKIT_WEB_VIEW(webview_));
+    webkit_user_content_manager_remove_all_scripts(manager);
+    webkit_user_content_manager_unregister_script_message_handler(manager,
+                                                                  "external");
+    g_signal_handlers_disconnect_by_data(manager, this);
+    g_signal_handlers_disconnect_by_data(webview_, this);
+    g_signal_handlers_disconnect_by_data(window_, this);
+
+    // Destroying the plug takes the overlay, webview and placeholder with it.
+    GtkWidget *window = window_;
+    window_ = overlay_ = webview_ = placeholder_ = nullptr;
+    gtk_widget_destroy(window);
+    while (gtk_events_pending()) gtk_main_iteration();
+  }
 
   DELEGATE_REFCOUNT(Steinberg::FObject)
   DEFINE_INTERFACES
@@ -114,12 +304,82 @@ class WebviewWebkitGTK : public Webview,
  protected:
   void DispatchIn(DispatchFunction f) override { f(); }
 
+  void SetDocumentScript(const std::string &js) override {
+    if (!webview_) return;
+    WebKitUserContentManager *manager =
+        webkit_web_view_get_user_content_manager(WEBKIT_WEB_VIEW(webview_));
+    // The document script is the only user script, so replace them all.
+    webkit_user_content_manager_remove_all_scripts(manager);
+    WebKitUserScript *script = webkit_user_script_new(
+        js.c_str(), WEBKIT_USER_CONTENT_INJECT_TOP_FRAME,
+        WEBKIT_USER_SCRIPT_INJECT_AT_DOCUMENT_START, nullptr, nullptr);
+    // The manager keeps its own reference.
+    webkit_user_content_manager_add_script(manager, script);
+    webkit_user_script_unref(script);
+  }
+
+  void DoNavigate(const std::string &url) override {
+    webkit_web_view_load_uri(WEBKIT_WEB_VIEW(webview_), url.c_str());
+  }
+
  private:
   void onTimer() override {
+    auto start = std::chrono::steady_clock::now();
     while (gtk_events_pending()) gtk_main_iteration();
+    RecordPumpTime(std::chrono::steady_clock::now() - start);
+    if (++visibility_poll_ticks_ >= kVisibilityPollTicks) {
+      visibility_poll_ticks_ = 0;
+      UpdateVisibility();
+    }
+    OnIdle();
+  }
+
+  // The plug is a child of the host's window, so it gets no map, unmap or
+  // window-state events when the host minimises or hides its own top-level
+  // window; poll the X server instead. IsViewable means the plug and every
+  // ancestor are mapped, and window managers unmap minimised windows.
+  void UpdateVisibility() {
+    if (!window_) return;
+    GdkWindow *gdk_window = gtk_widget_get_window(window_);
+    if (!gdk_window) return;
+    XWindowAttributes attributes;
+    if (!XGetWindowAttributes(
+            GDK_DISPLAY_XDISPLAY(gdk_window_get_display(gdk_window)),
+            GDK_WINDOW_XID(gdk_window), &attributes)) {
+      return;
+    }
+    SetVisible(attributes.map_state == IsViewable);
+  }
+
+  // WebKit gives no way to ask which web process renders a view, so this
+  // is a guess: the newest child web process no other view in this process
+  // has claimed. It is scanned for on first use rather than at open. With
+  // several editors, or a host that already runs WebKit itself, views can
+  // be matched to the wrong process, so the figures are approximate.
+  void FindWebProcess() {
+    ReleaseWebProcess();
+    auto &claimed = ClaimedWebProcesses();
+    auto current = ChildWebProcesses();
+    for (auto it = current.rbegin(); it != current.rend(); ++it) {
+      if (!claimed.count(*it)) {
+        web_process_id_ = *it;
+        web_process_claimed_ = true;
+        claimed.insert(*it);
+        return;
+      }
+    }
+    // With a shared-process model every view uses the same one.
+    if (current.size() == 1) web_process_id_ = *current.begin();
+  }
+
+  void ReleaseWebProcess() {
+    if (web_process_claimed_) ClaimedWebProcesses().erase(web_process_id_);
+    web_process_claimed_ = false;
+    web_process_id_ = 0;
+    last_sample_ticks_ = 0;
   }
 
-  void MakeWebView(bool debug) {
+  void MakeWebView(const WebviewOptions &options) {
     webview_ = webkit_web_view_new();
     WebKitUserContentManager *manager =
         webkit_web_view_get_user_content_manager(WEBKIT_WEB_VIEW(webview_));
@@ -138,6 +398,26 @@ class WebviewWebkitGTK : public Webview,
     webkit_user_content_manager_register_script_message_handler(manager,
                                                                 "external");
 
+    g_signal_connect(webview_, "load-changed",
+                     G_CALLBACK(+[](WebKitWebView *, WebKitLoadEvent event,
+                                    gpointer arg) {
+                       auto *w = static_cast<WebviewWebkitGTK *>(arg);
+                       switch (event) {
+                         case WEBKIT_LOAD_STARTED:
+                           w->OnLoadEvent(LoadEvent::kStarted);
+                           break;
+                         case WEBKIT_LOAD_COMMITTED:
+                           w->OnLoadEvent(LoadEvent::kCommitted);
+                           break;
+                         case WEBKIT_LOAD_FINISHED:
+                           w->OnLoadEvent(LoadEvent::kFinished);
+                           break;
+                         default:
+                           break;
+                       }
+                     }),
+                     this);
+
     WebKitSettings *settings = webkit_settings_new();
 
     webkit_settings_set_allow_file_access_from_file_urls(settings, true);
@@ -145,28 +425,72 @@ class WebviewWebkitGTK : public Webview,
     webkit_settings_set_javascript_can_access_clipboard(settings, true);
     webkit_settings_set_allow_modal_dialogs(settings, true);
 
-    if (debug) {
+    webkit_settings_set_enable_smooth_scrolling(settings,
+                                                options.smooth_scrolling);
+    webkit_settings_set_enable_page_cache(settings, options.page_cache);
+    switch (options.hardware_acceleration) {
+      case WebviewOptions::HardwareAcceleration::kAlways:
+        webkit_settings_set_hardware_acceleration_policy(
+            settings, WEBKIT_HARDWARE_ACCELERATION_POLICY_ALWAYS);
+        break;
+      case WebviewOptions::HardwareAcceleration::kNever:
+        webkit_settings_set_hardware_acceleration_policy(
+            settings, WEBKIT_HARDWARE_ACCELERATION_POLICY_NEVER);
+        break;
+      case WebviewOptions::HardwareAcceleration::kOnDemand:
+        webkit_settings_set_hardware_acceleration_policy(
+            settings, WEBKIT_HARDWARE_ACCELERATION_POLICY_ON_DEMAND);
+        break;
+      case WebviewOptions::HardwareAcceleration::kDefault:
+        break;
+    }
+    if (options.document_viewer_cache) {
+      webkit_web_context_set_cache_model(
+          webkit_web_view_get_context(WEBKIT_WEB_VIEW(webview_)),
+          WEBKIT_CACHE_MODEL_DOCUMENT_VIEWER);
+    }
+
+    if (options.debug) {
       webkit_settings_set_enable_write_console_messages_to_stdout(settings,
                                                                   true);
       webkit_settings_set_enable_developer_extras(settings, true);
     }
     webkit_web_view_set_settings(WEBKIT_WEB_VIEW(webview_), settings);
+    g_object_unref(settings);
   }
 
   Steinberg::FUnknownPtr<Steinberg::Linux::IRunLoop> run_loop_;
 
-  GtkWidget *window_;
-  GtkWidget *webview_;
+  GtkWidget *window_ = nullptr;
+  GtkWidget *overlay_ = nullptr;
+  GtkWidget *webview_ = nullptr;
+  GtkWidget *placeholder_ = nullptr;
+  GCancellable *snapshot_cancellable_ = g_cancellable_new();
+
+  // Size limits; 0 leaves a dimension unbounded.
+  int min_width_ = 0;
+  int min_height_ = 0;
+  int max_width_ = 0;
+  int max_height_ = 0;
+
+  // Each poll is a round trip to the X server, so only every few ticks.
+  static constexpr int kVisibilityPollTicks = 8;
+  int visibility_poll_ticks_ = 0;
+
+  int web_process_id_ = 0;
+  bool web_process_claimed_ = false;
+  uint64_t last_sample_ticks_ = 0;
+  std::chrono::steady_clock::time_point last_sample_;
 };
 
 // static
-std::unique_ptr<Webview> MakeWebview(bool debug,
+std::unique_ptr<Webview> MakeWebview(const WebviewOptions &options,
                                      Steinberg::IPlugFrame *plug_frame,
                                      void *window,
                                      WebviewCreatedCallback created_cb) {
   auto x11Parent = reinterpret_cast<XID>(window);
 
-  auto webview = std::make_unique<WebviewWebkitGTK>(debug, plug_frame,
+  auto webview = std::make_unique<WebviewWebkitGTK>(options, plug_frame,
                                                     x11Parent, created_cb);
   return std::move(webview);
 }
@@ -25,6 +25,7 @@
 
 // OSX Imports
 #include <CoreGraphics/CoreGraphics.h>
+#include <dispatch/dispatch.h>
 #include <objc/objc-runtime.h>
 
 #define NSBackingStoreBuffered 2
@@ -58,10 +59,30 @@ class WebviewOSX : public vstwebview::Webview {
                             ((id(*)(id, SEL))objc_msgSend)(msg, "body"_sel), "UTF8String"_sel));
                       }),
                       "v@:@@");
+      // WKNavigationDelegate, for document load events.
+      class_addMethod(cls, "webView:didStartProvisionalNavigation:"_sel,
+                      (IMP)(+[](id self, SEL, id, id) {
+                        auto w = (WebviewOSX *)objc_getAssociatedObject(self, "webview");
+                        if (w) w->OnLoadEvent(LoadEvent::kStarted);
+                      }),
+                      "v@:@@");
+      class_addMethod(cls, "webView:didCommitNavigation:"_sel,
+                      (IMP)(+[](id self, SEL, id, id) {
+                        auto w = (WebviewOSX *)objc_getAssociatedObject(self, "webview");
+                        if (w) w->OnLoadEvent(LoadEvent::kCommitted);
+                      }),
+                      "v@:@@");
+      class_addMethod(cls, "webView:didFinishNavigation:"_sel,
+                      (IMP)(+[](id self, SEL, id, id) {
+                        auto w = (WebviewOSX *)objc_getAssociatedObject(self, "webview");
+                        if (w) w->OnLoadEvent(LoadEvent::kFinished);
+                      }),
+                      "v@:@@");
       objc_registerClassPair(cls);
     }
 
     auto delegate = ((id(*)(id, SEL))objc_msgSend)((id)cls, "new"_sel);
+    delegate_ = delegate;
     objc_setAssociatedObject(delegate, "webview", (id)this, OBJC_ASSOCIATION_ASSIGN);
 
     // Webview config
@@ -103,13 +124,26 @@ class WebviewOSX : public vstwebview::Webview {
 
     ((void (*)(id, SEL, CGRect, id))objc_msgSend)(webview_, "initWithFrame:configuration:"_sel,
                                                   CGRectMake(0, 0, 100, 100), config);
+    // The webview keeps its own copy of the configuration.
+    ((void (*)(id, SEL))objc_msgSend)(config, "release"_sel);
+
+    ((void (*)(id, SEL, id))objc_msgSend)(webview_, "setNavigationDelegate:"_sel, delegate);
 
     ((void (*)(id, SEL, id))objc_msgSend)(parentView, "addSubview:"_sel, webview_);
 
     window_ = parentView;
 
+    // Drive idle callbacks roughly 60 times a second from the main queue.
+    idle_timer_ = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_main_queue());
+    dispatch_source_set_timer(idle_timer_, DISPATCH_TIME_NOW, 16 * NSEC_PER_MSEC, 4 * NSEC_PER_MSEC);
+    dispatch_source_set_event_handler(idle_timer_, ^{
+      OnIdle();
+    });
+    dispatch_resume(idle_timer_);
+
     created(this);
   }
+  ~WebviewOSX() override { Terminate(); }
   static char *plugin_path(void) {
     Dl_info info;
     if (dladdr((const char *)plugin_path, &info) != 0) {
@@ -139,16 +173,6 @@ class WebviewOSX : public vstwebview::Webview {
     // XXX relative path maybe?
     return "file://" + std::string(buffer);
   }
-  void OnDocumentCreate(const std::string &js) override {
-    ((void (*)(id, SEL, id))objc_msgSend)(
-        m_manager, "addUserScript:"_sel,
-        ((id(*)(id, SEL, id, long, BOOL))objc_msgSend)(
-            ((id(*)(id, SEL))objc_msgSend)("WKUserScript"_cls, "alloc"_sel),
-            "initWithSource:injectionTime:forMainFrameOnly:"_sel,
-            ((id(*)(id, SEL, const char *))objc_msgSend)("NSString"_cls,
-                                                         "stringWithUTF8String:"_sel, js.c_str()),
-            WKUserScriptInjectionTimeAtDocumentStart, 1));
-  }
   void SetTitle(const std::string &title) override {
     // XXX TODO - I don't think this is necessary since not creating a new window
   }
@@ -157,19 +181,26 @@ class WebviewOSX : public vstwebview::Webview {
     CGSize size = CGSizeMake(width, height);
     ((id(*)(id, SEL, CGSize))objc_msgSend)(webview_, "setFrameSize:"_sel, size);
   }
-  void Navigate(const std::string &url) override {
-    auto nsurl = ((id(*)(id, SEL, id))objc_msgSend)(
-        "NSURL"_cls, "URLWithString:"_sel,
-        ((id(*)(id, SEL, const char *))objc_msgSend)("NSString"_cls, "stringWithUTF8String:"_sel,
-                                                     url.c_str()));
-
-    ((void (*)(id, SEL, id))objc_msgSend)(
-        webview_, "loadRequest:"_sel,
-        ((id(*)(id, SEL, id))objc_msgSend)("NSURLRequest"_cls, "requestWithURL:"_sel, nsurl));
-  }
   void *PlatformWindow() const override { return window_; };
   void Terminate() override {
-    // XXX TODO - Might not be necessary since a sub view not an actual window
+    // The delegate only holds a weak pointer back to this object, and the
+    // user content controller retains the delegate, so break both links
+    // before the view goes away.
+    if (!webview_) return;
+    dispatch_source_cancel(idle_timer_);
+    // Not under ARC, so the source must be released as well as cancelled.
+    dispatch_release(idle_timer_);
+    idle_timer_ = nullptr;
+    objc_setAssociatedObject(delegate_, "webview", nil, OBJC_ASSOCIATION_ASSIGN);
+    ((void (*)(id, SEL, id))objc_msgSend)(m_manager, "removeScriptMessageHandlerForName:"_sel,
+                                          "external"_str);
+    ((void (*)(id, SEL))objc_msgSend)(m_manager, "removeAllUserScripts"_sel);
+    ((void (*)(id, SEL, id))objc_msgSend)(webview_, "setNavigationDelegate:"_sel, nil);
+    ((void (*)(id, SEL))objc_msgSend)(webview_, "removeFromSuperview"_sel);
+    ((void (*)(id, SEL))objc_msgSend)(webview_, "release"_sel);
+    ((void (*)(id, SEL))objc_msgSend)(delegate_, "release"_sel);
+    webview_ = nil;
+    delegate_ = nil;
   }
   void EvalJS(const std::string &js, ResultCallback rs) override {
     auto foo = ^(id ret, id err) {
@@ -194,20 +225,60 @@ class WebviewOSX : public vstwebview::Webview {
                                                      js.c_str()),
         (dispatch_block_t)foo);
   }
+  void ReleaseMemory() override {
+    // WKWebView cannot be asked to trim its web process; dropping its memory
+    // cache of decoded resources is the closest it offers.
+    if (!webview_) return;
+    id store = ((id(*)(id, SEL))objc_msgSend)(
+        ((id(*)(id, SEL))objc_msgSend)(webview_, "configuration"_sel), "websiteDataStore"_sel);
+    ((void (*)(id, SEL, id, id, dispatch_block_t))objc_msgSend)(
+        store, "removeDataOfTypes:modifiedSince:completionHandler:"_sel,
+        ((id(*)(id, SEL, id))objc_msgSend)("NSSet"_cls, "setWithObject:"_sel,
+                                           "WKWebsiteDataTypeMemoryCache"_str),
+        ((id(*)(id, SEL))objc_msgSend)("NSDate"_cls, "distantPast"_sel), ^{});
+  }
 
  protected:
   void DispatchIn(vstwebview::DispatchFunction f) override { f(); }
 
+  void SetDocumentScript(const std::string &js) override {
+    if (!webview_) return;
+    // The document script is the only user script, so replace them all.
+    ((void (*)(id, SEL))objc_msgSend)(m_manager, "removeAllUserScripts"_sel);
+    id script = ((id(*)(id, SEL, id, long, BOOL))objc_msgSend)(
+        ((id(*)(id, SEL))objc_msgSend)("WKUserScript"_cls, "alloc"_sel),
+        "initWithSource:injectionTime:forMainFrameOnly:"_sel,
+        ((id(*)(id, SEL, const char *))objc_msgSend)("NSString"_cls, "stringWithUTF8String:"_sel,
+                                                     js.c_str()),
+        WKUserScriptInjectionTimeAtDocumentStart, 1);
+    ((void (*)(id, SEL, id))objc_msgSend)(m_manager, "addUserScript:"_sel, script);
+    // The controller keeps its own reference.
+    ((void (*)(id, SEL))objc_msgSend)(script, "release"_sel);
+  }
+
+  void DoNavigate(const std::string &url) override {
+    auto nsurl = ((id(*)(id, SEL, id))objc_msgSend)(
+        "NSURL"_cls, "URLWithString:"_sel,
+        ((id(*)(id, SEL, const char *))objc_msgSend)("NSString"_cls, "stringWithUTF8String:"_sel,
+                                                     url.c_str()));
+
+    ((void (*)(id, SEL, id))objc_msgSend)(
+        webview_, "loadRequest:"_sel,
+        ((id(*)(id, SEL, id))objc_msgSend)("NSURLRequest"_cls, "requestWithURL:"_sel, nsurl));
+  }
+
  private:
   id window_;
   id webview_;
+  id delegate_;
   id m_manager;
+  dispatch_source_t idle_timer_;
 };
 
-std::unique_ptr<Webview> MakeWebview(bool debug, Steinberg::IPlugFrame *plug_frame, void *window,
+std::unique_ptr<Webview> MakeWebview(const WebviewOptions &options, Steinberg::IPlugFrame *plug_frame, void *window,
                                      WebviewCreatedCallback created_cb) {
   auto parentView = reinterpret_cast<id>(window);
-  auto webview = std::make_unique<WebviewOSX>(debug, plug_frame, parentView, created_cb);
+  auto webview = std::make_unique<WebviewOSX>(options.debug, plug_frame, parentView, created_cb);
   return std::move(webview);
 }
 }
@@ -0,0 +1,293 @@
+/*
+ * Copyright 2022 Ryan Daum
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vstwebview/parameter_search_index.h"
+
+#include <public.sdk/source/vst/utility/stringconvert.h>
+
+#include <algorithm>
+
+namespace vstwebview {
+
+namespace {
+
+// Case folding is ASCII only; other UTF-8 bytes are compared as they are.
+char Fold(char c) { return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c; }
+
+std::string FoldCase(std::string s) {
+  std::transform(s.begin(), s.end(), s.begin(), Fold);
+  return s;
+}
+
+bool IsWordChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+         static_cast<unsigned char>(c) >= 0x80;
+}
+
+uint32_t Trigram(const char *p) {
+  return (static_cast<uint32_t>(static_cast<unsigned char>(p[0])) << 16) |
+         (static_cast<uint32_t>(static_cast<unsigned char>(p[1])) << 8) |
+         static_cast<uint32_t>(static_cast<unsigned char>(p[2]));
+}
+
+template <typename Fn>
+void ForEachWord(const std::string &field, Fn fn) {
+  size_t i = 0;
+  while (i < field.size()) {
+    while (i < field.size() && !IsWordChar(field[i])) i++;
+    size_t begin = i;
+    while (i < field.size() && IsWordChar(field[i])) i++;
+    if (i > begin) fn(std::string_view(field).substr(begin, i - begin));
+  }
+}
+
+// Terms shorter than this use the word list instead of trigrams.
+constexpr size_t kMinTrigramTerm = 3;
+
+}  // namespace
+
+void ParameterSearchIndex::Build(const ParameterTable &params,
+                                 Steinberg::Vst::IUnitInfo *unit_info) {
+  Clear();
+  if (unit_info) {
+    for (Steinberg::int32 i = 0; i < unit_info->getUnitCount(); i++) {
+      Steinberg::Vst::UnitInfo info;
+      if (unit_info->getUnitInfo(i, info) != Steinberg::kResultOk) continue;
+      unit_names_[info.id] = FoldCase(VST3::StringConvert::convert(info.name));
+    }
+  }
+  docs_.reserve(params.size());
+  for (int slot = 0; slot < params.size(); slot++) {
+    docs_.push_back(MakeDocument(params, slot));
+    Index(slot, false);
+  }
+  std::sort(words_.begin(), words_.end());
+  words_.erase(std::unique(words_.begin(), words_.end(),
+                           [](const Word &a, const Word &b) {
+                             return a.text == b.text && a.slot == b.slot;
+                           }),
+               words_.end());
+  seen_.assign(docs_.size(), 0);
+}
+
+void ParameterSearchIndex::Clear() {
+  docs_.clear();
+  unit_names_.clear();
+  trigrams_.clear();
+  words_.clear();
+  seen_.clear();
+  seen_stamp_ = 0;
+}
+
+bool ParameterSearchIndex::Update(const ParameterTable &params, int slot) {
+  if (slot < 0 || slot >= static_cast<int>(docs_.size())) return false;
+  Document doc = MakeDocument(params, slot);
+  bool changed = false;
+  for (int f = 0; f < kNumFields; f++) {
+    changed |= doc.fields[f] != docs_[slot].fields[f];
+  }
+  if (!changed) return false;
+  Deindex(slot);
+  docs_[slot] = std::move(doc);
+  Index(slot, true);
+  return true;
+}
+
+int ParameterSearchIndex::Search(std::string_view query, int offset, int count,
+                                 std::vector<int> *out) {
+  out->clear();
+  int n = static_cast<int>(docs_.size());
+  // Both come from JS; bound them so offset + count cannot overflow.
+  offset = std::clamp(offset, 0, n);
+  count = std::clamp(count, 0, n - offset);
+
+  query_.assign(query.begin(), query.end());
+  std::transform(query_.begin(), query_.end(), query_.begin(), Fold);
+  terms_.clear();
+  ForEachWord(query_,
+              [this](std::string_view term) { terms_.push_back(term); });
+  if (terms_.empty()) {
+    for (int slot = offset; slot < offset + count; slot++) {
+      out->push_back(slot);
+    }
+    return n;
+  }
+
+  // Seed candidates from the most selective term; the rest are checked
+  // against each candidate's document.
+  const std::vector<int32_t> *best_postings = nullptr;
+  size_t best_size = SIZE_MAX;
+  std::string_view best_prefix;
+  for (auto term : terms_) {
+    if (term.size() >= kMinTrigramTerm) {
+      for (size_t i = 0; i + 3 <= term.size(); i++) {
+        auto it = trigrams_.find(Trigram(term.data() + i));
+        if (it == trigrams_.end()) return 0;
+        if (it->second.size() < best_size) {
+          best_size = it->second.size();
+          best_postings = &it->second;
+          best_prefix = {};
+        }
+      }
+    } else {
+      auto first = std::lower_bound(
+          words_.begin(), words_.end(), term,
+          [](const Word &w, std::string_view t) { return w.text < t; });
+      auto last = first;
+      while (last != words_.end() &&
+             std::string_view(last->text).substr(0, term.size()) == term) {
+        last++;
+      }
+      if (first == last) return 0;
+      if (static_cast<size_t>(last - first) < best_size) {
+        best_size = last - first;
+        best_postings = nullptr;
+        best_prefix = term;
+      }
+    }
+  }
+
+  candidates_.clear();
+  if (best_postings) {
+    candidates_.assign(best_postings->begin(), best_postings->end());
+  } else {
+    // Word prefixes can repeat a slot; stamp slots to skip duplicates.
+    if (++seen_stamp_ == 0) {
+      std::fill(seen_.begin(), seen_.end(), 0);
+      seen_stamp_ = 1;
+    }
+    auto it = std::lower_bound(
+        words_.begin(), words_.end(), best_prefix,
+        [](const Word &w, std::string_view t) { return w.text < t; });
+    for (; it != words_.end() &&
+           std::string_view(it->text).substr(0, best_prefix.size()) ==
+               best_prefix;
+         it++) {
+      if (seen_[it->slot] == seen_stamp_) continue;
+      seen_[it->slot] = seen_stamp_;
+      candidates_.push_back(it->slot);
+    }
+  }
+
+  matches_.clear();
+  for (auto slot : candidates_) {
+    int total = 0;
+    for (auto term : terms_) {
+      int score = Score(docs_[slot], term);
+      if (score < 0) {
+        total = -1;
+        break;
+      }
+      total += score;
+    }
+    if (total >= 0) matches_.emplace_back(total, slot);
+  }
+
+  int total = static_cast<int>(matches_.size());
+  if (offset >= total) return total;
+  auto end = matches_.begin() + offset + std::min(count, total - offset);
+  std::partial_sort(matches_.begin(), end, matches_.end());
+  for (auto it = matches_.begin() + offset; it != end; it++) {
+    out->push_back(it->second);
+  }
+  return total;
+}
+
+ParameterSearchIndex::Document ParameterSearchIndex::MakeDocument(
+    const ParameterTable &params, int slot) const {
+  const auto &info = params.param(slot)->getInfo();
+  Document doc;
+  doc.fields[kTitle] = FoldCase(VST3::StringConvert::convert(info.title));
+  doc.fields[kShortTitle] =
+      FoldCase(VST3::StringConvert::convert(info.shortTitle));
+  auto unit = unit_names_.find(params.unit_id(slot));
+  if (unit != unit_names_.end()) doc.fields[kUnitName] = unit->second;
+  return doc;
+}
+
+void ParameterSearchIndex::Index(int slot, bool sorted_insert) {
+  for (const auto &field : docs_[slot].fields) {
+    for (size_t i = 0; i + 3 <= field.size(); i++) {
+      auto &postings = trigrams_[Trigram(field.data() + i)];
+      if (!sorted_insert) {
+        // Build() adds slots in order, so only the last entry can repeat.
+        if (postings.empty() || postings.back() != slot)
+          postings.push_back(slot);
+        continue;
+      }
+      auto it = std::lower_bound(postings.begin(), postings.end(), slot);
+      if (it == postings.end() || *it != slot) postings.insert(it, slot);
+    }
+    ForEachWord(field, [&](std::string_view text) {
+      Word word{std::string(text), slot};
+      if (!sorted_insert) {
+        words_.push_back(std::move(word));
+        return;
+      }
+      auto it = std::lower_bound(words_.begin(), words_.end(), word);
+      if (it == words_.end() || it->text != word.text || it->slot != slot)
+        words_.insert(it, std::move(word));
+    });
+  }
+}
+
+void ParameterSearchIndex::Deindex(int slot) {
+  for (const auto &field : docs_[slot].fields) {
+    for (size_t i = 0; i + 3 <= field.size(); i++) {
+      auto found = trigrams_.find(Trigram(field.data() + i));
+      if (found == trigrams_.end()) continue;
+      auto &postings = found->second;
+      auto it = std::lower_bound(postings.begin(), postings.end(), slot);
+      if (it != postings.end() && *it == slot) postings.erase(it);
+      if (postings.empty()) trigrams_.erase(found);
+    }
+    ForEachWord(field, [&](std::string_view text) {
+      Word word{std::string(text), slot};
+      auto it = std::lower_bound(words_.begin(), words_.end(), word);
+      if (it != words_.end() && it->text == word.text && it->slot == slot)
+        words_.erase(it);
+    });
+  }
+}
+
+int ParameterSearchIndex::Score(const Document &doc, std::string_view term) {
+  // Per field: 0 whole field, 1 field prefix, 2 word prefix, 3 inside a word.
+  constexpr int kRanksPerField = 4;
+  int best = -1;
+  for (int f = 0; f < kNumFields; f++) {
+    const auto &field = doc.fields[f];
+    for (size_t pos = field.find(term); pos != std::string::npos;
+         pos = field.find(term, pos + 1)) {
+      int rank;
+      if (pos == 0) {
+        rank = field.size() == term.size() ? 0 : 1;
+      } else if (!IsWordChar(field[pos - 1])) {
+        rank = 2;
+      } else if (term.size() >= kMinTrigramTerm) {
+        rank = 3;
+      } else {
+        continue;
+      }
+      int score = f * kRanksPerField + rank;
+      if (best < 0 || score < best) best = score;
+      if (rank <= 2) break;
+    }
+    if (best >= 0) return best;
+  }
+  return best;
+}
+
+}  // namespace vstwebview
@@ -0,0 +1,143 @@
+// Copyright 2022 Ryan Daum
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vstwebview/parameter_table.h"
+
+#include <public.sdk/source/vst/utility/stringconvert.h>
+
+#include <algorithm>
+
+using nlohmann::json;
+
+namespace vstwebview {
+
+namespace {
+
+// Everything about a parameter except its current value.
+json SerializeMetadata(Steinberg::Vst::Parameter *param) {
+  auto &info = param->getInfo();
+  json j = {
+      {"precision", param->getUnitID()},
+      {"unitID", param->getUnitID()},
+      {"info",
+       {
+           {"id", info.id},
+           {"title", VST3::StringConvert::convert(info.title)},
+           {"stepCount", info.stepCount},
+           {"flags", info.flags},
+           {"defaultNormalizedValue", info.defaultNormalizedValue},
+           {"units", info.units},
+           {"shortTitle", VST3::StringConvert::convert(info.shortTitle)},
+       }},
+  };
+  bool isRangeParameter =
+      (param->isA(Steinberg::Vst::RangeParameter::getFClassID()));
+  j["isRangeParameter"] = isRangeParameter;
+  if (isRangeParameter) {
+    auto *range_param = dynamic_cast<Steinberg::Vst::RangeParameter *>(param);
+    j["min"] = range_param->getMin();
+    j["max"] = range_param->getMax();
+  }
+  return j;
+}
+
+}  // namespace
+
+void ParameterTable::Build(Steinberg::Vst::EditController *controller) {
+  Clear();
+  Steinberg::int32 count = controller->getParameterCount();
+  for (Steinberg::int32 i = 0; i < count; i++) {
+    Steinberg::Vst::ParameterInfo info;
+    if (controller->getParameterInfo(i, info) != Steinberg::kResultOk)
+      continue;
+    auto *param = controller->getParameterObject(info.id);
+    if (!param) continue;
+    ids_.push_back(info.id);
+    params_.push_back(param);
+    unit_ids_.push_back(info.unitId);
+    step_counts_.push_back(info.stepCount);
+  }
+
+  int n = size();
+  subscribers_.assign(n, 0);
+  versions_.assign(n, 0);
+  metadata_.resize(n);
+  metadata_json_.resize(n);
+  for (int slot = 0; slot < n; slot++) {
+    RefreshMetadata(slot);
+  }
+
+  if (n == 0) return;
+  // Keep the load factor at or below one half so probe runs stay short.
+  uint32_t bits = 1;
+  while ((1u << bits) < static_cast<uint32_t>(n) * 2) bits++;
+  hash_.assign(1u << bits, HashEntry{0, -1});
+  hash_mask_ = (1u << bits) - 1;
+  hash_shift_ = 32 - bits;
+  for (int slot = 0; slot < n; slot++) {
+    uint32_t h = Hash(ids_[slot]);
+    while (hash_[h].slot >= 0) {
+      // Duplicate IDs are a plugin bug; the first registration wins.
+      if (hash_[h].id == ids_[slot]) break;
+      h = (h + 1) & hash_mask_;
+    }
+    if (hash_[h].slot < 0) hash_[h] = {ids_[slot], slot};
+  }
+}
+
+void ParameterTable::Clear() {
+  hash_.clear();
+  hash_mask_ = 0;
+  hash_shift_ = 32;
+  ids_.clear();
+  params_.clear();
+  unit_ids_.clear();
+  step_counts_.clear();
+  subscribers_.clear();
+  versions_.clear();
+  metadata_.clear();
+  metadata_json_.clear();
+}
+
+bool ParameterTable::SetSubscribed(int slot, uint32_t view_bit,
+                                   bool subscribed) {
+  if (!view_bit || ((subscribers_[slot] & view_bit) != 0) == subscribed)
+    return false;
+  subscribers_[slot] ^= view_bit;
+  return true;
+}
+
+void ParameterTable::ClearSubscriptions(uint32_t view_bit) {
+  for (auto &subscribers : subscribers_) subscribers &= ~view_bit;
+}
+
+json ParameterTable::Serialize(int slot) const {
+  json j = metadata_[slot];
+  j["normalized"] = params_[slot]->getNormalized();
+  return j;
+}
+
+void ParameterTable::SerializeTo(int slot, std::string *out) const {
+  out->append("{\"normalized\":");
+  out->append(json(params_[slot]->getNormalized()).dump());
+  out->push_back(',');
+  out->append(metadata_json_[slot]);
+}
+
+void ParameterTable::RefreshMetadata(int slot) {
+  metadata_[slot] = SerializeMetadata(params_[slot]);
+  metadata_json_[slot] = metadata_[slot].dump().substr(1);
+}
+
+}  // namespace vstwebview
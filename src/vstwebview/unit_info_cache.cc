@@ -0,0 +1,192 @@
+/*
+ * Copyright 2022 Ryan Daum
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vstwebview/unit_info_cache.h"
+
+#include <public.sdk/source/vst/utility/stringconvert.h>
+
+#include <algorithm>
+
+using nlohmann::json;
+
+namespace vstwebview {
+
+namespace {
+
+// Cached pages are dropped wholesale past this many, as with the value
+// string cache; a browser only ever looks at a handful at a time.
+constexpr size_t kMaxCachedPages = 256;
+
+// Only the neighbours of recent requests are worth reading ahead.
+constexpr size_t kMaxQueuedPrefetches = 8;
+
+}  // namespace
+
+void UnitInfoCache::Reset(Steinberg::Vst::IUnitInfo *unit_info) {
+  unit_info_ = unit_info;
+  units_.clear();
+  program_lists_.clear();
+  pages_.clear();
+  prefetch_.clear();
+  if (!unit_info_) return;
+
+  units_.resize(std::max(unit_info_->getUnitCount(), 0));
+  auto list_count = unit_info_->getProgramListCount();
+  for (Steinberg::int32 i = 0; i < list_count; i++) {
+    Steinberg::Vst::ProgramListInfo info;
+    if (unit_info_->getProgramListInfo(i, info) != Steinberg::kResultOk)
+      continue;
+    program_lists_.push_back({info.id, VST3::StringConvert::convert(info.name),
+                              std::max(info.programCount, 0)});
+  }
+}
+
+json UnitInfoCache::Units(int offset, int count) {
+  json out = json::array();
+  offset = std::clamp(offset, 0, unit_count());
+  int end = offset + std::clamp(count, 0, unit_count() - offset);
+  for (int i = offset; i < end; i++) {
+    auto &unit = units_[i];
+    if (unit.is_null()) {
+      Steinberg::Vst::UnitInfo info;
+      if (unit_info_->getUnitInfo(i, info) != Steinberg::kResultOk) {
+        unit = json::object();
+      } else {
+        unit = {{"id", info.id},
+                {"parentUnitId", info.parentUnitId},
+                {"name", VST3::StringConvert::convert(info.name)},
+                {"programListId", info.programListId}};
+      }
+    }
+    out.push_back(unit);
+  }
+  return out;
+}
+
+json UnitInfoCache::ProgramLists() const {
+  json out = json::array();
+  for (const auto &list : program_lists_) {
+    out.push_back({{"id", list.id},
+                   {"name", list.name},
+                   {"programCount", list.program_count}});
+  }
+  return out;
+}
+
+json UnitInfoCache::ProgramNames(Steinberg::Vst::ProgramListID list_id,
+                                 int offset, int count) {
+  const auto *list = FindProgramList(list_id);
+  if (!list) return json();
+
+  offset = std::clamp(offset, 0, list->program_count);
+  int end = offset + std::clamp(count, 0, list->program_count - offset);
+  json names = json::array();
+  int first_page = offset / kPageSize;
+  int last_page = first_page;
+  for (int i = offset; i < end;) {
+    last_page = i / kPageSize;
+    const auto &page = LoadPage(*list, last_page);
+    int page_end = std::min(end, (last_page + 1) * kPageSize);
+    for (; i < page_end; i++) names.push_back(page[i % kPageSize]);
+  }
+  QueuePrefetch(*list, last_page + 1);
+  QueuePrefetch(*list, first_page - 1);
+
+  return {{"listId", list_id},
+          {"offset", offset},
+          {"total", list->program_count},
+          {"names", std::move(names)}};
+}
+
+void UnitInfoCache::InvalidateProgramList(
+    Steinberg::Vst::ProgramListID list_id) {
+  for (auto it = pages_.begin(); it != pages_.end();) {
+    if (static_cast<uint32_t>(it->first >> 32) ==
+        static_cast<uint32_t>(list_id)) {
+      it = pages_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  if (!unit_info_) return;
+  for (Steinberg::int32 i = 0; i < unit_info_->getProgramListCount(); i++) {
+    Steinberg::Vst::ProgramListInfo info;
+    if (unit_info_->getProgramListInfo(i, info) != Steinberg::kResultOk ||
+        info.id != list_id)
+      continue;
+    for (auto &list : program_lists_) {
+      if (list.id != list_id) continue;
+      list.name = VST3::StringConvert::convert(info.name);
+      list.program_count = std::max(info.programCount, 0);
+    }
+  }
+}
+
+bool UnitInfoCache::Prefetch() {
+  while (!prefetch_.empty()) {
+    uint64_t key = prefetch_.front();
+    prefetch_.pop_front();
+    if (pages_.count(key)) continue;
+    const auto *list =
+        FindProgramList(static_cast<Steinberg::Vst::ProgramListID>(key >> 32));
+    if (!list) continue;
+    LoadPage(*list, static_cast<int>(key & 0xffffffff));
+    return true;
+  }
+  return false;
+}
+
+const UnitInfoCache::ProgramList *UnitInfoCache::FindProgramList(
+    Steinberg::Vst::ProgramListID list_id) const {
+  for (const auto &list : program_lists_) {
+    if (list.id == list_id) return &list;
+  }
+  return nullptr;
+}
+
+const UnitInfoCache::Page &UnitInfoCache::LoadPage(const ProgramList &list,
+                                                   int page) {
+  auto key = PageKey(list.id, page);
+  auto it = pages_.find(key);
+  if (it != pages_.end()) return it->second;
+
+  if (pages_.size() >= kMaxCachedPages) pages_.clear();
+  Page names;
+  int begin = page * kPageSize;
+  int end = std::min(begin + kPageSize, list.program_count);
+  names.reserve(end - begin);
+  for (int i = begin; i < end; i++) {
+    Steinberg::Vst::String128 name;
+    if (unit_info_->getProgramName(list.id, i, name) == Steinberg::kResultOk) {
+      names.push_back(VST3::StringConvert::convert(name));
+    } else {
+      names.emplace_back();
+    }
+  }
+  return pages_.emplace(key, std::move(names)).first->second;
+}
+
+void UnitInfoCache::QueuePrefetch(const ProgramList &list, int page) {
+  if (page < 0 || page * kPageSize >= list.program_count) return;
+  auto key = PageKey(list.id, page);
+  if (pages_.count(key)) return;
+  if (std::find(prefetch_.begin(), prefetch_.end(), key) != prefetch_.end())
+    return;
+  if (prefetch_.size() >= kMaxQueuedPrefetches) prefetch_.pop_front();
+  prefetch_.push_back(key);
+}
+
+}  // namespace vstwebview
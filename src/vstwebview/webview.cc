@@ -14,41 +14,98 @@
 
 #include "vstwebview/webview.h"
 
+#include <algorithm>
 #include <utility>
 
 namespace vstwebview {
 
 void Webview::BindFunction(const std::string &name,
                            Webview::FunctionBinding f) {
-  auto js = "(function() { var name = '" + name + "';" + R"(
-     var RPC = window._rpc = (window._rpc || {nextSeq: 1});
-     window[name] = function() {
-       var seq = RPC.nextSeq++;
-       var promise = new Promise(function(resolve, reject) {
-         RPC[seq] = {
-           resolve: resolve,
-           reject: reject,
-         };
-       });
-       window.external.invoke(JSON.stringify({
-         id: seq,
-         method: name,
-         params: Array.prototype.slice.call(arguments),
-       }));
-       return promise;
-     }
-   })())";
-  OnDocumentCreate(js);
-  bindings_[name] = FunctionBinding(std::move(f));
+  bindings_[name] = {std::move(f), false};
+  document_script_dirty_ = true;
+}
+
+void Webview::BindNotification(const std::string &name,
+                               Webview::FunctionBinding f) {
+  bindings_[name] = {std::move(f), true};
+  document_script_dirty_ = true;
 }
 
 void Webview::UnbindFunction(const std::string &name) {
-  if (bindings_.find(name) != bindings_.end()) {
-    auto js = "delete window['" + name + "'];";
-    OnDocumentCreate(js);
-    EvalJS(js, [](const nlohmann::json &j) {});
-    bindings_.erase(name);
+  if (bindings_.erase(name) == 0) return;
+  document_script_dirty_ = true;
+  EvalJS("delete window['" + name + "'];", [](const nlohmann::json &j) {});
+}
+
+void Webview::OnDocumentCreate(const std::string &js) {
+  // Several bindings install the same runtime; once per page is enough.
+  if (std::find(document_scripts_.begin(), document_scripts_.end(), js) !=
+      document_scripts_.end()) {
+    return;
   }
+  document_scripts_.push_back(js);
+  document_script_dirty_ = true;
+}
+
+void Webview::SetSizeLimits(int min_width, int min_height, int max_width,
+                            int max_height) {
+  if (min_width > 0 || min_height > 0) {
+    SetViewSize(min_width, min_height, SizeHint::kMin);
+  }
+  if (max_width > 0 && max_height > 0) {
+    SetViewSize(max_width, max_height, SizeHint::kMax);
+  }
+}
+
+void Webview::Navigate(const std::string &url) {
+  UpdateDocumentScript();
+  DoNavigate(url);
+}
+
+void Webview::UpdateDocumentScript() {
+  if (!document_script_dirty_) return;
+  document_script_dirty_ = false;
+
+  // Every binding shares one stub per kind; only its name is listed.
+  std::string functions;
+  std::string notifications;
+  for (const auto &binding : bindings_) {
+    auto &names = binding.second.notification ? notifications : functions;
+    if (!names.empty()) names.push_back(',');
+    names.append(nlohmann::json(binding.first).dump());
+  }
+  std::string js = R"((function() {
+  var RPC = window._rpc = (window._rpc || {nextSeq: 1});
+  [)" + functions + R"(].forEach(function(name) {
+    window[name] = function() {
+      var seq = RPC.nextSeq++;
+      var promise = new Promise(function(resolve, reject) {
+        RPC[seq] = {resolve: resolve, reject: reject};
+      });
+      window.external.invoke(JSON.stringify({
+        id: seq,
+        method: name,
+        params: Array.prototype.slice.call(arguments),
+      }));
+      return promise;
+    };
+  });
+  [)" + notifications + R"(].forEach(function(name) {
+    window[name] = function() {
+      window.external.invoke(JSON.stringify({
+        method: name,
+        params: Array.prototype.slice.call(arguments),
+      }));
+    };
+  });
+})();
+)";
+  for (const auto &script : document_scripts_) {
+    js.append("try {\n");
+    js.append(script);
+    js.append("\n} catch (e) { console.error(e); }\n");
+  }
+  SetDocumentScript(js);
 }
 
 void Webview::ResolveFunctionDispatch(int seq, int status,
@@ -70,15 +127,116 @@ void Webview::ResolveFunctionDispatch(int seq, int status,
 
 void Webview::OnBrowserMessage(const std::string &msg) {
   nlohmann::json msg_parsed = nlohmann::json::parse(msg);
-  int seq = msg_parsed["id"];
+  // Notifications carry no sequence number and expect no reply.
+  bool is_notification = !msg_parsed.contains("id");
+  int seq = is_notification ? 0 : msg_parsed["id"].get<int>();
   std::string name = msg_parsed["method"];
   nlohmann::json args = msg_parsed["params"];
   const auto &it = bindings_.find(name);
   if (it == bindings_.end()) {
     return;
   }
-  auto result = it->second(this, seq, name, args);
-  ResolveFunctionDispatch(seq, 0, result);
+  auto start = std::chrono::steady_clock::now();
+  auto result = it->second.fn(this, seq, name, args);
+  if (!is_notification) {
+    ResolveFunctionDispatch(seq, 0, result);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  call_time_ += elapsed;
+  calls_++;
+  if (!call_observers_.empty()) {
+    call_observer_ids_.clear();
+    for (const auto &observer : call_observers_) {
+      call_observer_ids_.push_back(observer.first);
+    }
+    for (int id : call_observer_ids_) {
+      auto observer = call_observers_.find(id);
+      if (observer != call_observers_.end()) observer->second(name, elapsed);
+    }
+  }
+}
+
+int Webview::AddIdleCallback(Webview::IdleCallback cb) {
+  int id = next_idle_callback_id_++;
+  idle_callbacks_[id] = std::move(cb);
+  return id;
+}
+
+void Webview::RemoveIdleCallback(int id) { idle_callbacks_.erase(id); }
+
+void Webview::OnIdle() {
+  auto start = std::chrono::steady_clock::now();
+  // Bindings added after navigation are picked up by the next page load.
+  UpdateDocumentScript();
+  // Callbacks may add or remove idle callbacks, so iterate over a snapshot
+  // of the ids and re-check each one before calling it.
+  idle_ids_.clear();
+  for (const auto &callback : idle_callbacks_) {
+    idle_ids_.push_back(callback.first);
+  }
+  for (int id : idle_ids_) {
+    auto it = idle_callbacks_.find(id);
+    if (it != idle_callbacks_.end()) it->second();
+  }
+  RecordPumpTime(std::chrono::steady_clock::now() - start);
+  idle_ticks_++;
+}
+
+void Webview::RecordPumpTime(std::chrono::steady_clock::duration elapsed) {
+  pump_time_ += elapsed;
+}
+
+ResourceUsage Webview::GetResourceUsage() {
+  ResourceUsage usage;
+  usage.pump_seconds = std::chrono::duration<double>(pump_time_).count();
+  usage.idle_ticks = idle_ticks_;
+  usage.call_seconds = std::chrono::duration<double>(call_time_).count();
+  usage.calls = calls_;
+  return usage;
+}
+
+int Webview::AddLoadCallback(Webview::LoadCallback cb) {
+  int id = next_load_callback_id_++;
+  load_callbacks_[id] = std::move(cb);
+  return id;
+}
+
+void Webview::RemoveLoadCallback(int id) { load_callbacks_.erase(id); }
+
+int Webview::AddCallObserver(Webview::CallObserver cb) {
+  int id = next_call_observer_id_++;
+  call_observers_[id] = std::move(cb);
+  return id;
+}
+
+void Webview::RemoveCallObserver(int id) { call_observers_.erase(id); }
+
+void Webview::SetVisible(bool visible) {
+  if (visible == visible_) return;
+  visible_ = visible;
+  auto callbacks = visibility_callbacks_;
+  for (auto &callback : callbacks) {
+    callback.second(visible);
+  }
+}
+
+int Webview::AddVisibilityCallback(Webview::VisibilityCallback cb) {
+  int id = next_visibility_callback_id_++;
+  visibility_callbacks_[id] = std::move(cb);
+  return id;
+}
+
+void Webview::RemoveVisibilityCallback(int id) {
+  visibility_callbacks_.erase(id);
+}
+
+void Webview::OnLoadEvent(Webview::LoadEvent event) {
+  // Load events are rare, so simply iterate over a copy in case a callback
+  // adds or removes load callbacks.
+  auto callbacks = load_callbacks_;
+  for (auto &callback : callbacks) {
+    callback.second(event);
+  }
 }
 
 }  // namespace vstwebview
\ No newline at end of file
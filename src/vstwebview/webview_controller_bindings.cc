@@ -16,73 +16,143 @@
 
 #include <public.sdk/source/vst/utility/stringconvert.h>
 
+#include <algorithm>
+#include <cmath>
 #include <codecvt>
+#include <cstdint>
+#include <functional>
+#include <limits>
 #include <locale>
+#include <string>
 
 #include "pluginterfaces/base/ustring.h"
+#include "vstwebview/binary_encoding.h"
 
 namespace vstwebview {
 
 namespace {
 
-json SerializeParameter(Steinberg::Vst::Parameter *param) {
-  auto &info = param->getInfo();
-  json j = {
-      {"normalized", param->getNormalized()},
-      {"precision", param->getUnitID()},
-      {"unitID", param->getUnitID()},
-      {"info",
-       {
-           {"id", info.id},
-           {"title", VST3::StringConvert::convert(info.title)},
-           {"stepCount", info.stepCount},
-           {"flags", info.flags},
-           {"defaultNormalizedValue", info.defaultNormalizedValue},
-           {"units", info.units},
-           {"shortTitle", VST3::StringConvert::convert(info.shortTitle)},
-       }},
-  };
-  bool isRangeParameter =
-      (param->isA(Steinberg::Vst::RangeParameter::getFClassID()));
-  j["isRangeParameter"] = isRangeParameter;
-  if (isRangeParameter) {
-    auto *range_param = dynamic_cast<Steinberg::Vst::RangeParameter *>(param);
-    j["min"] = range_param->getMin();
-    j["max"] = range_param->getMax();
-  }
-  return j;
-}
-
-// Proxy IDependent through the webview for parameter object changes.
+// Proxy IDependent changes on parameter objects back to the bindings.
 class ParameterDependenciesProxy : public Steinberg::FObject {
 public:
-  explicit ParameterDependenciesProxy(vstwebview::Webview *webview)
-      : webview_(webview) {}
+  using ChangedFn = std::function<void(Steinberg::Vst::Parameter *)>;
+  explicit ParameterDependenciesProxy(ChangedFn changed_fn)
+      : changed_fn_(std::move(changed_fn)) {}
 
   void update(FUnknown *changedUnknown, Steinberg::int32 message) override {
-    if (!webview_ || message != IDependent::kChanged) return;
+    if (message != IDependent::kChanged) return;
 
-    Steinberg::Vst::Parameter *changed_param;
-    auto query_result = changedUnknown->queryInterface(
-        Steinberg::Vst::RangeParameter::iid, (void **)&changed_param);
+    auto *changed_param =
+        Steinberg::FCast<Steinberg::Vst::Parameter>(changedUnknown);
+    if (!changed_param) return;
 
-    if (query_result != Steinberg::kResultOk) return;
-
-    webview_->EvalJS("notifyParameterChange(" +
-                         SerializeParameter(changed_param).dump() + ");",
-                     [](const json &r) {});
+    changed_fn_(changed_param);
   }
 
 private:
-  vstwebview::Webview *webview_;
+  ChangedFn changed_fn_;
+};
+
+// Typed-array front ends for the packed (base64 Float64) readers.
+constexpr char kPackedReadersJS[] = R"(
+window.getParamsNormalized = function(ids) {
+  return window._getParamsNormalizedPacked(ids).then(function(packed) {
+    return window.vstwebview.decodeBinary(packed, 'f64');
+  });
 };
+window.getParamsSnapshot = function(sinceVersion, epoch) {
+  return window._getParamsSnapshotPacked(sinceVersion || 0, epoch || '')
+      .then(function(s) {
+        s.values = window.vstwebview.decodeBinary(s.values, 'f64');
+        return s;
+      });
+};
+)";
+
+// vstwebview.syncParameters() resolves to {version, values: {id: value},
+// changed: [ids]}. The last snapshot is kept in localStorage, which unlike
+// sessionStorage outlives the webview, so after a reload or an editor reopen
+// only parameters changed since then are fetched. Entries are keyed by the
+// page's path, i.e. per plugin bundle; an entry left by an earlier session
+// or by another instance of the plugin carries a different epoch, and the
+// snapshot then comes back full.
+constexpr char kStateCacheJS[] = R"(
+(function() {
+  var vw = window.vstwebview = window.vstwebview || {};
+  var key = 'vstwebview.parameters:' + location.pathname;
+  vw.syncParameters = function() {
+    var cached = null;
+    try { cached = JSON.parse(localStorage.getItem(key)); } catch (e) {}
+    return window.getParamsSnapshot(cached ? cached.version : 0,
+                                    cached ? cached.epoch : '')
+        .then(function(s) {
+          var values = (cached && !s.full) ? cached.values : {};
+          for (var i = 0; i < s.ids.length; i++) values[s.ids[i]] = s.values[i];
+          try {
+            localStorage.setItem(key, JSON.stringify(
+                {epoch: s.epoch, version: s.version, values: values}));
+          } catch (e) {}
+          return {version: s.version, values: values, changed: s.ids};
+        });
+  };
+})();
+)";
+
+// sendMessage front end: ArrayBuffer and typed array attributes are sent as
+// {"$binary": base64} and land in IAttributeList::setBinary.
+constexpr char kSendMessageJS[] = R"(
+window.sendMessage = function(messageId, attributes) {
+  var out = {};
+  for (var key in attributes) {
+    var value = attributes[key];
+    out[key] = (value instanceof ArrayBuffer || ArrayBuffer.isView(value)) ?
+        {'$binary': window.vstwebview.encodeBinary(value)} : value;
+  }
+  return window._sendMessage(messageId, out);
+};
+)";
+
+// Stepped parameters with more steps than this are cached like continuous
+// ones rather than getting a full precomputed table.
+constexpr Steinberg::int32 kMaxPrecomputedSteps = 256;
+
+// Continuous values are quantised to this many buckets for caching, well
+// below anything a parameter display string can resolve.
+constexpr double kValueStringQuantisation = 1 << 20;
+
+// Upper bound on cached continuous value strings before the cache is reset.
+constexpr size_t kMaxCachedValueStrings = 1 << 16;
+
+// Time spent filling step tables per idle callback, well inside a frame.
+constexpr auto kPrecomputeBudget = std::chrono::milliseconds(1);
+
+// Accepts either a single integer or an array of them.
+std::vector<Steinberg::Vst::ParamID> ParamIDList(const json &j) {
+  std::vector<Steinberg::Vst::ParamID> ids;
+  if (j.is_array()) {
+    for (const auto &id : j) ids.push_back(id);
+  } else if (j.is_number()) {
+    ids.push_back(j);
+  }
+  return ids;
+}
 
 }  // namespace
 
 WebviewControllerBindings::WebviewControllerBindings(
     Steinberg::Vst::EditControllerEx1 *controller)
     : thread_checker_(Steinberg::Vst::ThreadChecker::create()),
+      param_dep_proxy_(std::make_unique<ParameterDependenciesProxy>(
+          [this](Steinberg::Vst::Parameter *param) {
+            OnParameterChanged(param);
+          })),
       controller_(controller) {
+  // Versions restart with every bindings instance, so snapshots carry an
+  // epoch that lets a page tell its cached version is from someone else.
+  epoch_ = std::to_string(
+               std::chrono::steady_clock::now().time_since_epoch().count()) +
+           "-" + std::to_string(reinterpret_cast<uintptr_t>(this));
+
   DeclareJSBinding(
       "getParameterObject",
       BindCallback(&WebviewControllerBindings::GetParameterObject));
@@ -92,6 +162,17 @@ WebviewControllerBindings::WebviewControllerBindings(
   DeclareJSBinding(
       "subscribeParameter",
       BindCallback(&WebviewControllerBindings::SubscribeParameter));
+  DeclareJSBinding("subscribeUnit",
+                   BindCallback(&WebviewControllerBindings::SubscribeUnit));
+  DeclareJSBinding(
+      "subscribeAllParameters",
+      BindCallback(&WebviewControllerBindings::SubscribeAllParameters));
+  DeclareJSBinding(
+      "unsubscribeParameter",
+      BindCallback(&WebviewControllerBindings::UnsubscribeParameter));
+  DeclareJSBinding(
+      "unsubscribeAllParameters",
+      BindCallback(&WebviewControllerBindings::UnsubscribeAllParameters));
   DeclareJSBinding(
       "setParamNormalized",
       BindCallback(&WebviewControllerBindings::SetParameterNormalized));
@@ -101,26 +182,330 @@ WebviewControllerBindings::WebviewControllerBindings(
   DeclareJSBinding(
       "getParamNormalized",
       BindCallback(&WebviewControllerBindings::GetParamNormalized));
+  DeclareJSBinding(
+      "_getParamsNormalizedPacked",
+      BindCallback(&WebviewControllerBindings::GetParamsNormalized));
+  DeclareJSBinding(
+      "_getParamsSnapshotPacked",
+      BindCallback(&WebviewControllerBindings::GetParamsSnapshot));
   DeclareJSBinding("beginEdit",
                    BindCallback(&WebviewControllerBindings::BeginEdit));
   DeclareJSBinding("performEdit",
                    BindCallback(&WebviewControllerBindings::PerformEdit));
   DeclareJSBinding("endEdit",
                    BindCallback(&WebviewControllerBindings::EndEdit));
+  DeclareJSBinding(
+      "beginEditGesture",
+      BindCallback(&WebviewControllerBindings::BeginEditGesture));
+  DeclareJSNotification(
+      "editGestureValue",
+      BindCallback(&WebviewControllerBindings::EditGestureValue));
+  DeclareJSBinding("endEditGesture",
+                   BindCallback(&WebviewControllerBindings::EndEditGesture));
+  DeclareJSBinding(
+      "getParamStringByValue",
+      BindCallback(&WebviewControllerBindings::GetParamStringByValue));
+  DeclareJSBinding(
+      "getParamValueByString",
+      BindCallback(&WebviewControllerBindings::GetParamValueByString));
   DeclareJSBinding("getParameterCount",
                    BindCallback(&WebviewControllerBindings::GetParameterCount));
   DeclareJSBinding("getSelectedUnit",
                    BindCallback(&WebviewControllerBindings::GetSelectedUnit));
   DeclareJSBinding("selectUnit",
                    BindCallback(&WebviewControllerBindings::SelectUnit));
-  DeclareJSBinding("sendMessage",
+  DeclareJSBinding(
+      "searchParameters",
+      BindCallback(&WebviewControllerBindings::SearchParameters));
+  DeclareJSBinding("getUnits",
+                   BindCallback(&WebviewControllerBindings::GetUnits));
+  DeclareJSBinding("getProgramLists",
+                   BindCallback(&WebviewControllerBindings::GetProgramLists));
+  DeclareJSBinding("getProgramNames",
+                   BindCallback(&WebviewControllerBindings::GetProgramNames));
+  DeclareJSBinding("_sendMessage",
                    BindCallback(&WebviewControllerBindings::DoSendMessage));
 }
 
+WebviewControllerBindings::~WebviewControllerBindings() { RemoveDependents(); }
+
 void WebviewControllerBindings::Bind(vstwebview::Webview *webview) {
+  if (FindView(webview) ||
+      views_.size() >= static_cast<size_t>(ParameterTable::kMaxViews)) {
+    return;
+  }
+  if (views_.empty()) {
+    RebuildParameterIndex();
+    units_.Reset(controller_);
+    search_index_.Build(params_, controller_);
+  }
   for (auto &binding : bindings_) {
     webview->BindFunction(binding.first, binding.second);
   }
+  for (auto &notification : notifications_) {
+    webview->BindNotification(notification.first, notification.second);
+  }
+  webview->OnDocumentCreate(kBinaryRuntimeJS);
+  webview->OnDocumentCreate(kPackedReadersJS);
+  webview->OnDocumentCreate(kStateCacheJS);
+  webview->OnDocumentCreate(kSendMessageJS);
+
+  uint32_t used = 0;
+  for (const auto &view : views_) used |= view.bit;
+  View view;
+  view.webview = webview;
+  view.bit = ~used & (used + 1);
+  // Shared work is done once per tick, from whichever view is first.
+  view.idle_callback_id = webview->AddIdleCallback([this, webview]() {
+    if (views_.front().webview == webview) OnIdle();
+  });
+  view.visibility_callback_id = webview->AddVisibilityCallback(
+      [this, webview](bool visible) { OnVisibilityChanged(webview, visible); });
+  // A page unloaded mid-drag never sends its endEditGesture.
+  view.load_callback_id =
+      webview->AddLoadCallback([this, webview](Webview::LoadEvent event) {
+        if (event == Webview::LoadEvent::kStarted) EndEditGestures(webview);
+      });
+  views_.push_back(view);
+  released_ = false;
+  OnVisibilityChanged(webview, webview->visible());
+}
+
+void WebviewControllerBindings::Unbind(vstwebview::Webview *webview) {
+  auto *view = FindView(webview);
+  if (!view) return;
+  EndEditGestures(webview);
+  webview->RemoveIdleCallback(view->idle_callback_id);
+  webview->RemoveVisibilityCallback(view->visibility_callback_id);
+  webview->RemoveLoadCallback(view->load_callback_id);
+  params_.ClearSubscriptions(view->bit);
+  views_.erase(views_.begin() + (view - views_.data()));
+  if (!views_.empty()) return;
+  RemoveDependents();
+  search_index_.Clear();
+  // Nothing is left to look at the caches; drop them with the last view.
+  ReleaseMemory();
+}
+
+void WebviewControllerBindings::ReleaseMemoryFor(
+    vstwebview::Webview *webview) {
+  // Another view on screen is still reading the caches.
+  if (std::any_of(views_.begin(), views_.end(),
+                  [](const View &view) { return !view.hidden; })) {
+    return;
+  }
+  ReleaseMemory();
+}
+
+void WebviewControllerBindings::ReleaseMemory() {
+  thread_checker_->test();
+  // Value strings and unit pages are refilled on demand; step tables are
+  // rebuilt from the idle callback.
+  decltype(value_strings_)().swap(value_strings_);
+  for (auto &strings : step_strings_) {
+    strings.clear();
+    strings.shrink_to_fit();
+  }
+  step_strings_cursor_ = 0;
+  released_ = true;
+  units_.Reset(views_.empty() ? nullptr : controller_);
+  packed_values_.clear();
+  packed_values_.shrink_to_fit();
+  packed_out_.clear();
+  packed_out_.shrink_to_fit();
+  binary_buffer_.clear();
+  binary_buffer_.shrink_to_fit();
+  notify_js_.clear();
+  notify_js_.shrink_to_fit();
+  changes_json_.clear();
+  changes_json_.shrink_to_fit();
+  changes_.clear();
+  changes_.shrink_to_fit();
+  search_results_.clear();
+  search_results_.shrink_to_fit();
+}
+
+WebviewControllerBindings::View *WebviewControllerBindings::FindView(
+    vstwebview::Webview *webview) {
+  for (auto &view : views_) {
+    if (view.webview == webview) return &view;
+  }
+  return nullptr;
+}
+
+uint32_t WebviewControllerBindings::ViewBit(vstwebview::Webview *webview) {
+  auto *view = FindView(webview);
+  return view ? view->bit : 0;
+}
+
+void WebviewControllerBindings::EvalJSAll(const std::string &js) {
+  for (auto &view : views_) {
+    view.webview->EvalJS(js, [](const json &r) {});
+  }
+}
+
+void WebviewControllerBindings::OnIdle() {
+  FlushEditGestures();
+  // Read-ahead only pays off for a page someone is looking at, and would
+  // undo a release made while the editor is hidden.
+  if (released_ || std::none_of(views_.begin(), views_.end(),
+                                [](const View &view) { return !view.hidden; }))
+    return;
+  if (!units_.Prefetch()) PrecomputeStepStrings();
+}
+
+void WebviewControllerBindings::OnVisibilityChanged(
+    vstwebview::Webview *webview, bool visible) {
+  auto *view = FindView(webview);
+  if (!view || visible == !view->hidden) return;
+  view->hidden = !visible;
+  if (visible) released_ = false;
+  if (view->hidden) {
+    // A view hidden again before its catch-up went out still needs it.
+    if (!view->catch_up) view->hidden_version = state_version_;
+    view->catch_up = false;
+    return;
+  }
+  view->catch_up = true;
+  if (state_change_depth_ == 0) FlushCatchUps();
+}
+
+void WebviewControllerBindings::FlushCatchUps() {
+  for (auto &view : views_) {
+    if (view.hidden || !view.catch_up) continue;
+    view.catch_up = false;
+    NotifyChanges(view.hidden_version, nullptr, view.bit);
+  }
+}
+
+void WebviewControllerBindings::SetEditGestureRate(double hz) {
+  edit_gesture_interval_ =
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(hz > 0 ? 1.0 / hz : 0));
+}
+
+void WebviewControllerBindings::RebuildParameterIndex() {
+  // Parameters are fixed once the controller is initialized, but the view may
+  // be created before or after that, so the table is (re)built on bind.
+  RemoveDependents();
+  params_.Build(controller_);
+  // Changes made while no view was bound went unobserved, so every
+  // parameter counts as changed for a page holding an older version.
+  ++state_version_;
+  for (int slot = 0; slot < params_.size(); slot++) {
+    params_.set_version(slot, state_version_);
+  }
+  step_strings_.assign(params_.size(), {});
+  value_strings_.clear();
+  step_strings_cursor_ = 0;
+
+  // Every parameter is observed so that change versions stay current; the
+  // subscription bits only decide what gets pushed to the UI.
+  for (int slot = 0; slot < params_.size(); slot++) {
+    params_.param(slot)->addDependent(param_dep_proxy_.get());
+  }
+}
+
+void WebviewControllerBindings::RemoveDependents() {
+  for (int slot = 0; slot < params_.size(); slot++) {
+    params_.param(slot)->removeDependent(param_dep_proxy_.get());
+  }
+  params_.Clear();
+}
+
+bool WebviewControllerBindings::Subscribe(uint32_t view_bit, int index) {
+  return index >= 0 && params_.SetSubscribed(index, view_bit, true);
+}
+
+bool WebviewControllerBindings::Unsubscribe(uint32_t view_bit, int index) {
+  return index >= 0 && params_.SetSubscribed(index, view_bit, false);
+}
+
+void WebviewControllerBindings::UnsubscribeAll(uint32_t view_bit) {
+  params_.ClearSubscriptions(view_bit);
+}
+
+void WebviewControllerBindings::OnParameterChanged(
+    Steinberg::Vst::Parameter *param) {
+  int index = params_.Find(param->getInfo().id);
+  if (index < 0) return;
+  params_.set_version(index, ++state_version_);
+  uint32_t subscribers = params_.subscribers(index);
+  if (!subscribers || state_change_depth_ > 0) return;
+  bool serialized = false;
+  for (auto &view : views_) {
+    if (!(subscribers & view.bit) || view.hidden || view.catch_up) continue;
+    if (!serialized) {
+      notify_js_.assign("notifyParameterChange(");
+      params_.SerializeTo(index, &notify_js_);
+      notify_js_.append(");");
+      serialized = true;
+    }
+    view.webview->EvalJS(notify_js_, [](const json &r) {});
+  }
+}
+
+void WebviewControllerBindings::BeginStateChange() {
+  if (state_change_depth_++ > 0) return;
+  state_change_version_ = state_version_;
+  state_change_values_.resize(params_.size());
+  for (int slot = 0; slot < params_.size(); slot++) {
+    state_change_values_[slot] = params_.param(slot)->getNormalized();
+  }
+}
+
+void WebviewControllerBindings::EndStateChange() {
+  if (state_change_depth_ == 0 || --state_change_depth_ > 0) return;
+  // A new state can change how values read (e.g. tempo-synced times).
+  InvalidateValueStrings();
+  uint32_t live = 0;
+  for (const auto &view : views_) {
+    if (!view.hidden && !view.catch_up) live |= view.bit;
+  }
+  NotifyChanges(state_change_version_, &state_change_values_, live);
+  FlushCatchUps();
+}
+
+void WebviewControllerBindings::NotifyChanges(uint64_t since,
+                                              const std::vector<double> *before,
+                                              uint32_t view_mask) {
+  if (!view_mask) return;
+  changes_json_.clear();
+  changes_.clear();
+  for (int slot = 0; slot < params_.size(); slot++) {
+    uint32_t subscribers = params_.subscribers(slot) & view_mask;
+    if (!subscribers || params_.version(slot) <= since ||
+        (before &&
+         params_.param(slot)->getNormalized() == (*before)[slot])) {
+      continue;
+    }
+    params_.SerializeTo(slot, &changes_json_);
+    changes_.emplace_back(subscribers, changes_json_.size());
+  }
+  if (changes_.empty()) return;
+
+  // Pages that define notifyParameterChanges get the whole batch at once;
+  // others get their usual per-parameter callback, still in one script.
+  for (auto &view : views_) {
+    if (!(view_mask & view.bit)) continue;
+    notify_js_.assign(
+        "(function(c){if(window.notifyParameterChanges){"
+        "notifyParameterChanges(c);}else{c.forEach(function(p){"
+        "notifyParameterChange(p);});}})([");
+    bool any = false;
+    size_t begin = 0;
+    for (const auto &change : changes_) {
+      if (change.first & view.bit) {
+        if (any) notify_js_.push_back(',');
+        notify_js_.append(changes_json_, begin, change.second - begin);
+        any = true;
+      }
+      begin = change.second;
+    }
+    if (!any) continue;
+    notify_js_.append("]);");
+    view.webview->EvalJS(notify_js_, [](const json &r) {});
+  }
 }
 
 vstwebview::Webview::FunctionBinding WebviewControllerBindings::BindCallback(
@@ -133,10 +518,9 @@ vstwebview::Webview::FunctionBinding WebviewControllerBindings::BindCallback(
 json WebviewControllerBindings::GetParameterObject(vstwebview::Webview *webview,
                                                    const json &in) {
   thread_checker_->test();
-  int id = in[0];
-  auto *param = controller_->getParameterObject(id);
-  if (!param) return json();
-  return SerializeParameter(param);
+  int index = params_.Find(in[0]);
+  if (index < 0) return json();
+  return params_.Serialize(index);
 }
 
 json WebviewControllerBindings::GetParameterObjects(
@@ -144,9 +528,9 @@ json WebviewControllerBindings::GetParameterObjects(
   thread_checker_->test();
   json out;
   for (int id : in[0]) {
-    auto *param = controller_->getParameterObject(id);
-    if (param) {
-      out[id] = SerializeParameter(param);
+    int index = params_.Find(id);
+    if (index >= 0) {
+      out[id] = params_.Serialize(index);
     }
   }
   return out;
@@ -155,28 +539,73 @@ json WebviewControllerBindings::GetParameterObjects(
 json WebviewControllerBindings::SetParameterNormalized(
     vstwebview::Webview *webview, const json &in) {
   thread_checker_->test();
-  int tag = in[0];
+  int index = params_.Find(in[0]);
+  if (index < 0) return false;
   double value = in[1];
-  json out =
-      controller_->setParamNormalized(tag, value) == Steinberg::kResultOk;
-  return out;
+  params_.param(index)->setNormalized(value);
+  return true;
 }
 
 json WebviewControllerBindings::NormalizedParamToPlain(
     vstwebview::Webview *webview, const json &in) {
   thread_checker_->test();
-  int tag = in[0];
+  int index = params_.Find(in[0]);
   double value = in[1];
-  json out = controller_->normalizedParamToPlain(tag, value);
-  return out;
+  // EditController passes the value through for unknown parameters.
+  if (index < 0) return value;
+  return params_.param(index)->toPlain(value);
 }
 
 json WebviewControllerBindings::GetParamNormalized(vstwebview::Webview *webview,
                                                    const json &in) {
   thread_checker_->test();
-  int tag = in[0];
-  json out = controller_->getParamNormalized(tag);
-  return out;
+  int index = params_.Find(in[0]);
+  if (index < 0) return 0.0;
+  return params_.param(index)->getNormalized();
+}
+
+json WebviewControllerBindings::GetParamsNormalized(
+    vstwebview::Webview *webview, const json &in) {
+  thread_checker_->test();
+  packed_values_.clear();
+  for (const auto &id : in[0]) {
+    int index = params_.Find(id);
+    // Unknown IDs read as NaN so the packed array stays aligned with 'ids'.
+    packed_values_.push_back(index < 0
+                                 ? std::numeric_limits<double>::quiet_NaN()
+                                 : params_.param(index)->getNormalized());
+  }
+  packed_out_.clear();
+  Base64Encode(packed_values_.data(), packed_values_.size() * sizeof(double),
+               &packed_out_);
+  return packed_out_;
+}
+
+json WebviewControllerBindings::GetParamsSnapshot(vstwebview::Webview *webview,
+                                                  const json &in) {
+  thread_checker_->test();
+  uint64_t since =
+      in.empty() || !in[0].is_number() ? 0 : in[0].get<uint64_t>();
+  // A version from another epoch means nothing here; send everything.
+  if (in.size() > 1 && in[1].is_string() && !in[1].get<std::string>().empty() &&
+      in[1].get<std::string>() != epoch_) {
+    since = 0;
+  }
+  json ids = json::array();
+  packed_values_.clear();
+  for (int slot = 0; slot < params_.size(); slot++) {
+    if (params_.version(slot) <= since && since != 0) continue;
+    ids.push_back(params_.id(slot));
+    packed_values_.push_back(params_.param(slot)->getNormalized());
+  }
+  packed_out_.clear();
+  Base64Encode(packed_values_.data(), packed_values_.size() * sizeof(double),
+               &packed_out_);
+  return {{"epoch", epoch_},
+          {"version", state_version_},
+          {"full", since == 0},
+          {"ids", ids},
+          {"values", packed_out_}};
 }
 
 json WebviewControllerBindings::BeginEdit(vstwebview::Webview *webview,
@@ -204,6 +633,182 @@ json WebviewControllerBindings::EndEdit(vstwebview::Webview *webview,
   return out;
 }
 
+json WebviewControllerBindings::BeginEditGesture(vstwebview::Webview *webview,
+                                                 const json &in) {
+  thread_checker_->test();
+  Steinberg::Vst::ParamID tag = in[0];
+  if (edit_gestures_.count(tag)) return true;
+  if (controller_->beginEdit(tag) != Steinberg::kResultOk) return false;
+  edit_gestures_[tag].webview = webview;
+  return true;
+}
+
+json WebviewControllerBindings::EditGestureValue(vstwebview::Webview *webview,
+                                                 const json &in) {
+  thread_checker_->test();
+  Steinberg::Vst::ParamID tag = in[0];
+  auto it = edit_gestures_.find(tag);
+  if (it == edit_gestures_.end()) return json();
+  auto &gesture = it->second;
+  gesture.value = in[1];
+  gesture.pending = true;
+  // Write straight through if the throttle interval has already elapsed;
+  // otherwise the idle flush picks up the latest value.
+  if (std::chrono::steady_clock::now() - gesture.last_write >=
+      edit_gesture_interval_) {
+    WriteEditGestureValue(tag, gesture);
+  }
+  return json();
+}
+
+json WebviewControllerBindings::EndEditGesture(vstwebview::Webview *webview,
+                                               const json &in) {
+  thread_checker_->test();
+  Steinberg::Vst::ParamID tag = in[0];
+  auto it = edit_gestures_.find(tag);
+  if (it == edit_gestures_.end()) return false;
+  if (in.size() > 1 && in[1].is_number()) {
+    it->second.value = in[1];
+    it->second.pending = true;
+  }
+  if (it->second.pending) WriteEditGestureValue(tag, it->second);
+  edit_gestures_.erase(it);
+  return controller_->endEdit(tag) == Steinberg::kResultOk;
+}
+
+void WebviewControllerBindings::WriteEditGestureValue(
+    Steinberg::Vst::ParamID id, EditGesture &gesture) {
+  gesture.pending = false;
+  gesture.last_write = std::chrono::steady_clock::now();
+  controller_->setParamNormalized(id, gesture.value);
+  controller_->performEdit(id, gesture.value);
+}
+
+void WebviewControllerBindings::FlushEditGestures() {
+  if (edit_gestures_.empty()) return;
+  auto now = std::chrono::steady_clock::now();
+  for (auto &gesture : edit_gestures_) {
+    if (gesture.second.pending &&
+        now - gesture.second.last_write >= edit_gesture_interval_) {
+      WriteEditGestureValue(gesture.first, gesture.second);
+    }
+  }
+}
+
+void WebviewControllerBindings::EndEditGestures(
+    vstwebview::Webview *webview) {
+  for (auto it = edit_gestures_.begin(); it != edit_gestures_.end();) {
+    if (it->second.webview != webview) {
+      ++it;
+      continue;
+    }
+    if (it->second.pending) WriteEditGestureValue(it->first, it->second);
+    controller_->endEdit(it->first);
+    it = edit_gestures_.erase(it);
+  }
+}
+
+json WebviewControllerBindings::GetParamStringByValue(
+    vstwebview::Webview *webview, const json &in) {
+  thread_checker_->test();
+  int index = params_.Find(in[0]);
+  if (index < 0) return json();
+  const json &values = in[1];
+  if (!values.is_array()) return ParamValueToString(index, values);
+  json out = json::array();
+  for (const auto &value : values) {
+    out.push_back(ParamValueToString(index, value));
+  }
+  return out;
+}
+
+json WebviewControllerBindings::GetParamValueByString(
+    vstwebview::Webview *webview, const json &in) {
+  thread_checker_->test();
+  Steinberg::Vst::ParamID tag = in[0];
+  auto convert = [this, tag](const std::string &str) -> json {
+    auto u16 = VST3::StringConvert::convert(str);
+    Steinberg::Vst::ParamValue value;
+    if (controller_->getParamValueByString(
+            tag, const_cast<Steinberg::Vst::TChar *>(
+                     reinterpret_cast<const Steinberg::Vst::TChar *>(
+                         u16.c_str())),
+            value) != Steinberg::kResultOk) {
+      return json();
+    }
+    return value;
+  };
+  const json &strings = in[1];
+  if (!strings.is_array()) return convert(strings.get<std::string>());
+  json out = json::array();
+  for (const auto &str : strings) {
+    out.push_back(convert(str.get<std::string>()));
+  }
+  return out;
+}
+
+const std::string &WebviewControllerBindings::ParamValueToString(int index,
+                                                                 double value) {
+  value = std::clamp(value, 0.0, 1.0);
+  auto step_count = params_.step_count(index);
+  if (step_count > 0 && BuildStepStrings(index)) {
+    return step_strings_[index][static_cast<size_t>(
+        std::lround(value * step_count))];
+  }
+
+  auto bucket =
+      static_cast<uint64_t>(std::lround(value * kValueStringQuantisation));
+  uint64_t key = (static_cast<uint64_t>(index) << 32) | bucket;
+  auto it = value_strings_.find(key);
+  if (it != value_strings_.end()) return it->second;
+
+  if (value_strings_.size() >= kMaxCachedValueStrings) value_strings_.clear();
+  Steinberg::Vst::String128 str;
+  std::string converted;
+  if (controller_->getParamStringByValue(params_.id(index), value,
+                                         str) == Steinberg::kResultOk) {
+    converted = VST3::StringConvert::convert(str);
+  }
+  return value_strings_.emplace(key, std::move(converted)).first->second;
+}
+
+void WebviewControllerBindings::InvalidateValueStrings() {
+  value_strings_.clear();
+  // Step tables keep their capacity; the idle callback refills them.
+  for (auto &strings : step_strings_) strings.clear();
+  step_strings_cursor_ = 0;
+}
+
+bool WebviewControllerBindings::BuildStepStrings(int index) {
+  auto step_count = params_.step_count(index);
+  if (step_count <= 0 || step_count > kMaxPrecomputedSteps) return false;
+  auto &strings = step_strings_[index];
+  if (!strings.empty()) return true;
+
+  auto id = params_.id(index);
+  strings.resize(step_count + 1);
+  for (Steinberg::int32 step = 0; step <= step_count; step++) {
+    Steinberg::Vst::String128 str;
+    if (controller_->getParamStringByValue(
+            id, static_cast<double>(step) / step_count, str) ==
+        Steinberg::kResultOk) {
+      strings[step] = VST3::StringConvert::convert(str);
+    }
+  }
+  return true;
+}
+
+void WebviewControllerBindings::PrecomputeStepStrings() {
+  auto deadline = std::chrono::steady_clock::now() + kPrecomputeBudget;
+  while (step_strings_cursor_ < static_cast<size_t>(params_.size())) {
+    int slot = static_cast<int>(step_strings_cursor_++);
+    if (step_strings_[slot].empty() && BuildStepStrings(slot) &&
+        std::chrono::steady_clock::now() >= deadline) {
+      return;
+    }
+  }
+}
+
 json WebviewControllerBindings::GetParameterCount(vstwebview::Webview *webview,
                                                   const json &in) {
   thread_checker_->test();
@@ -225,17 +830,125 @@ json WebviewControllerBindings::SelectUnit(vstwebview::Webview *webview,
   return out;
 }
 
+json WebviewControllerBindings::SearchParameters(vstwebview::Webview *webview,
+                                                 const json &in) {
+  thread_checker_->test();
+  if (in.empty() || !in[0].is_string()) return json();
+  int offset = in.size() > 1 && in[1].is_number() ? in[1].get<int>() : 0;
+  int count = in.size() > 2 && in[2].is_number() ? in[2].get<int>()
+                                                  : params_.size();
+  int total = search_index_.Search(in[0].get_ref<const std::string &>(),
+                                   offset, count, &search_results_);
+  json ids = json::array();
+  for (int slot : search_results_) ids.push_back(params_.id(slot));
+  return {{"offset", offset}, {"total", total}, {"ids", std::move(ids)}};
+}
+
+void WebviewControllerBindings::RefreshParameterTitles() {
+  thread_checker_->test();
+  InvalidateValueStrings();
+  json changed = json::array();
+  for (int slot = 0; slot < params_.size(); slot++) {
+    if (!search_index_.Update(params_, slot)) continue;
+    params_.RefreshMetadata(slot);
+    changed.push_back(params_.id(slot));
+  }
+  if (changed.empty()) return;
+  EvalJSAll("if(window.notifyParameterTitlesChanged){"
+            "notifyParameterTitlesChanged(" +
+            changed.dump() + ");}");
+}
+
+json WebviewControllerBindings::GetUnits(vstwebview::Webview *webview,
+                                         const json &in) {
+  thread_checker_->test();
+  int offset = in.size() > 0 && in[0].is_number() ? in[0].get<int>() : 0;
+  int count = in.size() > 1 && in[1].is_number() ? in[1].get<int>()
+                                                  : units_.unit_count();
+  return {{"offset", offset},
+          {"total", units_.unit_count()},
+          {"units", units_.Units(offset, count)}};
+}
+
+json WebviewControllerBindings::GetProgramLists(vstwebview::Webview *webview,
+                                                const json &in) {
+  thread_checker_->test();
+  return units_.ProgramLists();
+}
+
+json WebviewControllerBindings::GetProgramNames(vstwebview::Webview *webview,
+                                                const json &in) {
+  thread_checker_->test();
+  if (in.empty() || !in[0].is_number()) return json();
+  int offset = in.size() > 1 && in[1].is_number() ? in[1].get<int>() : 0;
+  int count = in.size() > 2 && in[2].is_number() ? in[2].get<int>()
+                                                  : UnitInfoCache::kPageSize;
+  return units_.ProgramNames(in[0].get<Steinberg::Vst::ProgramListID>(),
+                             offset, count);
+}
+
+void WebviewControllerBindings::InvalidateProgramList(
+    Steinberg::Vst::ProgramListID list_id) {
+  thread_checker_->test();
+  units_.InvalidateProgramList(list_id);
+  EvalJSAll("if(window.notifyProgramListChange){"
+            "notifyProgramListChange(" +
+            std::to_string(list_id) + ");}");
+}
+
 json WebviewControllerBindings::SubscribeParameter(vstwebview::Webview *webview,
                                                    const json &in) {
   thread_checker_->test();
-  json out = controller_->getParameterCount();
-  int tag = in[0];
-  auto *param = controller_->getParameterObject(tag);
-  if (!param) return json();
-  if (!param_dep_proxy_) {
-    param_dep_proxy_ = std::make_unique<ParameterDependenciesProxy>(webview);
+  bool found = false;
+  for (auto id : ParamIDList(in[0])) {
+    int index = params_.Find(id);
+    if (index < 0) continue;
+    Subscribe(ViewBit(webview), index);
+    found = true;
   }
-  param->addDependent(param_dep_proxy_.get());
+  if (!found) return json();
+  return true;
+}
+
+json WebviewControllerBindings::SubscribeUnit(vstwebview::Webview *webview,
+                                              const json &in) {
+  thread_checker_->test();
+  Steinberg::Vst::UnitID unit_id = in[0];
+  uint32_t view_bit = ViewBit(webview);
+  int subscribed = 0;
+  for (int slot = 0; slot < params_.size(); slot++) {
+    if (params_.unit_id(slot) == unit_id && Subscribe(view_bit, slot))
+      subscribed++;
+  }
+  return subscribed;
+}
+
+json WebviewControllerBindings::SubscribeAllParameters(
+    vstwebview::Webview *webview, const json &in) {
+  thread_checker_->test();
+  uint32_t view_bit = ViewBit(webview);
+  int subscribed = 0;
+  for (int slot = 0; slot < params_.size(); slot++) {
+    if (Subscribe(view_bit, slot)) subscribed++;
+  }
+  return subscribed;
+}
+
+json WebviewControllerBindings::UnsubscribeParameter(
+    vstwebview::Webview *webview, const json &in) {
+  thread_checker_->test();
+  uint32_t view_bit = ViewBit(webview);
+  int unsubscribed = 0;
+  for (auto id : ParamIDList(in[0])) {
+    if (Unsubscribe(view_bit, params_.Find(id))) unsubscribed++;
+  }
+  return unsubscribed;
+}
+
+json WebviewControllerBindings::UnsubscribeAllParameters(
+    vstwebview::Webview *webview, const json &in) {
+  thread_checker_->test();
+  UnsubscribeAll(ViewBit(webview));
   return true;
 }
 
@@ -243,7 +956,7 @@ json WebviewControllerBindings::DoSendMessage(vstwebview::Webview *webview,
                                               const json &in) {
   thread_checker_->test();
   std::string messageId = in[0];
-  json attributes = in[1];
+  const json &attributes = in[1];
   if (auto msg = owned(controller_->allocateMessage())) {
     msg->setMessageID(messageId.c_str());
     auto msg_attrs = msg->getAttributes();
@@ -257,13 +970,23 @@ json WebviewControllerBindings::DoSendMessage(vstwebview::Webview *webview,
                  type == json::value_t::boolean) {
         msg_attrs->setInt(attr_id, k.value());
       } else if (type == json::value_t::string) {
-        std::string str = k.value();
-        Steinberg::Vst::TChar t_char_str[128];
-        VST3::StringConvert::convert(str, t_char_str);
-        msg_attrs->setString(attr_id, t_char_str);
-      } else if (type == json::value_t::binary) {
-        json::binary_t b = k.value();
-        msg_attrs->setBinary(attr_id, b.data(), b.size());
+        // Strings of any length, rather than a fixed TChar[128].
+        auto str = VST3::StringConvert::convert(
+            k.value().get_ref<const std::string &>());
+        msg_attrs->setString(attr_id,
+                             reinterpret_cast<const Steinberg::Vst::TChar *>(
+                                 str.c_str()));
+      } else if (type == json::value_t::object &&
+                 k.value().contains("$binary") &&
+                 k.value().at("$binary").is_string()) {
+        // Typed arrays arrive base64 encoded; decode into a reused buffer.
+        const auto &encoded =
+            k.value().at("$binary").get_ref<const std::string &>();
+        if (Base64Decode(encoded, &binary_buffer_)) {
+          msg_attrs->setBinary(
+              attr_id, binary_buffer_.data(),
+              static_cast<Steinberg::uint32>(binary_buffer_.size()));
+        }
       }
     }
     controller_->sendMessage(msg);
@@ -277,4 +1000,9 @@ void WebviewControllerBindings::DeclareJSBinding(
   bindings_.push_back({name, binding});
 }
 
+void WebviewControllerBindings::DeclareJSNotification(
+    const std::string &name, vstwebview::Webview::FunctionBinding binding) {
+  notifications_.push_back({name, binding});
+}
+
 }  // namespace vstwebview
\ No newline at end of file
@@ -0,0 +1,178 @@
+// Copyright 2022 Ryan Daum
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vstwebview/webview_data_exchange.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "base/source/fdebug.h"
+#include "vstwebview/binary_encoding.h"
+#include "vstwebview/webview.h"
+
+namespace vstwebview {
+
+namespace {
+
+// The ring indices wrap at 2^32, so the slot count must divide it.
+size_t RoundUpToPowerOfTwo(Steinberg::uint32 n) {
+  size_t size = 1;
+  while (size < n) size <<= 1;
+  return size;
+}
+
+}  // namespace
+
+WebviewDataExchange::WebviewDataExchange(const std::string &receiver,
+                                         const std::string &element_type,
+                                         Steinberg::uint32 max_block_size,
+                                         Steinberg::uint32 num_slots)
+    : receiver_(receiver),
+      element_type_(element_type),
+      element_size_(BinaryElementSize(element_type)),
+      max_block_size_(max_block_size),
+      slots_(RoundUpToPowerOfTwo(num_slots)),
+      slot_mask_(static_cast<uint32_t>(slots_.size()) - 1),
+      storage_(static_cast<size_t>(max_block_size) * slots_.size()),
+      fallback_handler_(this) {}
+
+void WebviewDataExchange::Bind(vstwebview::Webview *webview) {
+  for (const auto &view : views_) {
+    if (view.webview == webview) return;
+  }
+  webview->OnDocumentCreate(kBinaryRuntimeJS);
+  // The ring has one consumer; drain it from whichever view is first.
+  int idle_callback_id = webview->AddIdleCallback([this, webview]() {
+    if (views_.front().webview == webview) Drain();
+  });
+  views_.push_back({webview, idle_callback_id});
+}
+
+void WebviewDataExchange::Unbind(vstwebview::Webview *webview) {
+  auto it = std::find_if(
+      views_.begin(), views_.end(),
+      [webview](const View &view) { return view.webview == webview; });
+  if (it == views_.end()) return;
+  webview->RemoveIdleCallback(it->idle_callback_id);
+  views_.erase(it);
+  if (!views_.empty()) return;
+  // Discard whatever is pending; nobody is left to show it.
+  read_.store(write_.load(std::memory_order_acquire),
+              std::memory_order_release);
+  ReleaseMemory();
+}
+
+void PLUGIN_API WebviewDataExchange::queueOpened(
+    Steinberg::Vst::DataExchangeUserContextID id, Steinberg::uint32 block_size,
+    Steinberg::TBool &background_thread) {
+  // Copying into the ring is cheap and thread safe, so take blocks on the
+  // host's background thread and keep the UI thread free for drawing.
+  background_thread = true;
+  if (block_size > max_block_size_) {
+    // Nothing can be pushing while no queue is open, so the slots can be
+    // reallocated; with another queue live they must stay put.
+    if (open_queues_ == 0) {
+      max_block_size_ = block_size;
+      storage_.assign(static_cast<size_t>(block_size) * slots_.size(), 0);
+      read_.store(write_.load(std::memory_order_acquire),
+                  std::memory_order_release);
+    } else {
+      rejected_queues_++;
+      FDebugPrint(
+          "WebviewDataExchange: queue %u has %u-byte blocks, over the "
+          "%u-byte slots; its blocks will be dropped\n",
+          static_cast<unsigned>(id), static_cast<unsigned>(block_size),
+          static_cast<unsigned>(max_block_size_));
+    }
+  }
+  open_queues_++;
+}
+
+void PLUGIN_API WebviewDataExchange::queueClosed(
+    Steinberg::Vst::DataExchangeUserContextID id) {
+  if (open_queues_ > 0) open_queues_--;
+}
+
+void PLUGIN_API WebviewDataExchange::onDataExchangeBlocksReceived(
+    Steinberg::Vst::DataExchangeUserContextID id, Steinberg::uint32 num_blocks,
+    Steinberg::Vst::DataExchangeBlock *blocks,
+    Steinberg::TBool background_thread) {
+  for (Steinberg::uint32 i = 0; i < num_blocks; i++) {
+    Push(id, blocks[i].data, blocks[i].size);
+  }
+}
+
+bool WebviewDataExchange::OnMessage(Steinberg::Vst::IMessage *message) {
+  return fallback_handler_.onMessage(message);
+}
+
+bool WebviewDataExchange::Push(Steinberg::Vst::DataExchangeUserContextID id,
+                               const void *data, Steinberg::uint32 size) {
+  auto write = write_.load(std::memory_order_relaxed);
+  auto read = read_.load(std::memory_order_acquire);
+  // A block that is not a whole number of elements is not what the page
+  // asked for, most likely a queue set up for another element type.
+  if (size > max_block_size_ || size % element_size_ != 0 ||
+      write - read >= slots_.size()) {
+    dropped_blocks_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  auto index = write & slot_mask_;
+  std::memcpy(storage_.data() + static_cast<size_t>(index) * max_block_size_,
+              data, size);
+  slots_[index] = {id, size};
+  write_.store(write + 1, std::memory_order_release);
+  return true;
+}
+
+void WebviewDataExchange::ReleaseMemory() {
+  // The ring itself stays; the processor may push into it at any time.
+  js_.clear();
+  js_.shrink_to_fit();
+}
+
+void WebviewDataExchange::Drain() {
+  auto read = read_.load(std::memory_order_relaxed);
+  auto write = write_.load(std::memory_order_acquire);
+  if (read == write) return;
+  if (std::none_of(views_.begin(), views_.end(),
+                   [](const View &view) { return view.webview->visible(); })) {
+    // Nobody is looking; stale blocks are of no use once the page is shown.
+    read_.store(write, std::memory_order_release);
+    return;
+  }
+
+  js_.clear();
+  for (; read != write; read++) {
+    auto index = read & slot_mask_;
+    const auto &slot = slots_[index];
+    js_.append(receiver_);
+    js_.append("(vstwebview.decodeBinary(\"");
+    Base64Encode(storage_.data() + static_cast<size_t>(index) * max_block_size_,
+                 slot.size, &js_);
+    js_.append("\",\"");
+    js_.append(element_type_);
+    js_.append("\"),");
+    js_.append(std::to_string(slot.id));
+    js_.append(");");
+  }
+  read_.store(read, std::memory_order_release);
+
+  for (const auto &view : views_) {
+    if (view.webview->visible())
+      view.webview->EvalJS(js_, [](const nlohmann::json &) {});
+  }
+}
+
+}  // namespace vstwebview
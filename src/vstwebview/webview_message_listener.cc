@@ -16,72 +16,526 @@
 
 #include <public.sdk/source/vst/utility/stringconvert.h>
 
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <unordered_map>
+
+#include "vstwebview/binary_encoding.h"
 #include "vstwebview/webview.h"
 
 namespace vstwebview {
 
+namespace {
+
+// Strings longer than this are assumed to be malformed rather than grown into.
+constexpr size_t kMaxStringChars = 1 << 20;
+
+using AttributeType = WebviewMessageListener::MessageAttribute::Type;
+
+const char *BinaryElementType(AttributeType type) {
+  using Type = AttributeType;
+  switch (type) {
+  case Type::BINARY_F32:
+    return "f32";
+  case Type::BINARY_I16:
+    return "i16";
+  case Type::BINARY_I32:
+    return "i32";
+  case Type::BINARY_U8:
+    return "u8";
+  case Type::BINARY:
+  case Type::BINARY_F64:
+  default:
+    return "f64";
+  }
+}
+
+void AppendInt(Steinberg::int64 value, std::string *out) {
+  char buffer[24];
+  auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  out->append(buffer, result.ptr);
+}
+
+void AppendDouble(double value, std::string *out) {
+  // JSON has no representation for non-finite values.
+  if (!std::isfinite(value)) {
+    out->append("null");
+    return;
+  }
+  char buffer[32];
+  int len = std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+  out->append(buffer, len);
+}
+
+size_t HashMessageID(std::string_view id) {
+  return std::hash<std::string_view>()(id);
+}
+
+}  // namespace
+
+WebviewMessageListener::~WebviewMessageListener() {
+  while (!views_.empty()) Unbind(views_.back().webview);
+}
+
+void WebviewMessageListener::Bind(vstwebview::Webview *webview) {
+  for (const auto &view : views_) {
+    if (view.webview == webview) return;
+  }
+  // The page may already be loaded, so install the runtime both now and for
+  // later documents.
+  webview->OnDocumentCreate(kBinaryRuntimeJS);
+  webview->EvalJS(kBinaryRuntimeJS, [](const nlohmann::json &) {});
+  webview->BindFunction(
+      "subscribeMessage",
+      [this](Webview *webview, int, const std::string &, const json &in) {
+        return SubscribeFromPage(webview, in);
+      });
+  webview->BindFunction(
+      "unsubscribeMessage",
+      [this](Webview *webview, int, const std::string &, const json &in) {
+        return UnsubscribeFromPage(webview, in);
+      });
+  webview->BindFunction(
+      "replayMessages",
+      [this](Webview *webview, int, const std::string &, const json &in) {
+        return ReplayMessages(webview, in);
+      });
+  View view;
+  view.webview = webview;
+  // Held messages are flushed once per tick, from whichever view is first.
+  view.idle_callback_id = webview->AddIdleCallback([this, webview]() {
+    if (views_.front().webview == webview) FlushPending();
+  });
+  view.load_callback_id =
+      webview->AddLoadCallback([this, webview](Webview::LoadEvent event) {
+        if (event != Webview::LoadEvent::kStarted) return;
+        // The old document's handlers are gone; stop doing work for them.
+        RemoveReceivers(nullptr, [webview](const Receiver &receiver) {
+          return receiver.page == webview;
+        });
+      });
+  view.visibility_callback_id = webview->AddVisibilityCallback(
+      [this, webview](bool visible) { OnVisibilityChanged(webview, visible); });
+  view.hidden_version = message_version_;
+  views_.push_back(view);
+  for (auto &subscription : subscriptions_) UpdateCalls(subscription);
+}
+
+void WebviewMessageListener::Unbind(vstwebview::Webview *webview) {
+  auto it = std::find_if(
+      views_.begin(), views_.end(),
+      [webview](const View &view) { return view.webview == webview; });
+  if (it == views_.end()) return;
+  webview->RemoveIdleCallback(it->idle_callback_id);
+  webview->RemoveLoadCallback(it->load_callback_id);
+  webview->RemoveVisibilityCallback(it->visibility_callback_id);
+  webview->UnbindFunction("subscribeMessage");
+  webview->UnbindFunction("unsubscribeMessage");
+  webview->UnbindFunction("replayMessages");
+  views_.erase(it);
+  // The page goes with the webview.
+  RemoveReceivers(nullptr, [webview](const Receiver &receiver) {
+    return receiver.page == webview;
+  });
+  for (auto &subscription : subscriptions_) UpdateCalls(subscription);
+}
+
+void WebviewMessageListener::Subscribe(
+    const std::string &receiver, const std::string &message_id,
+    const std::vector<MessageAttribute> &attributes,
+    const DeliveryPolicy &policy) {
+  AddReceiver(receiver, message_id, attributes, policy, nullptr);
+}
+
 void WebviewMessageListener::Subscribe(
     const std::string &receiver, const std::string &message_id,
     const std::vector<MessageAttribute> &attributes) {
-  subscriptions_[message_id] = {message_id, attributes, receiver};
+  Subscribe(receiver, message_id, attributes, DeliveryPolicy());
+}
+
+void WebviewMessageListener::Unsubscribe(const std::string &receiver,
+                                         const std::string &message_id) {
+  RemoveReceivers(message_id.c_str(), [&receiver](const Receiver &r) {
+    return r.function == receiver;
+  });
+}
+
+void WebviewMessageListener::Unsubscribe(const std::string &receiver) {
+  RemoveReceivers(nullptr, [&receiver](const Receiver &r) {
+    return r.function == receiver;
+  });
+}
+
+void WebviewMessageListener::AddReceiver(
+    const std::string &receiver, const std::string &message_id,
+    const std::vector<MessageAttribute> &attributes,
+    const DeliveryPolicy &policy, vstwebview::Webview *page) {
+  auto *subscription = FindSubscription(message_id.c_str());
+  if (!subscription) {
+    subscriptions_.emplace_back();
+    subscription = &subscriptions_.back();
+  }
+
+  for (const auto &attr : attributes) {
+    auto it = std::find_if(
+        subscription->attributes.begin(), subscription->attributes.end(),
+        [&attr](const MessageAttribute &a) { return a.name == attr.name; });
+    if (it == subscription->attributes.end()) {
+      subscription->attributes.push_back(attr);
+    } else {
+      it->type = attr.type;
+    }
+  }
+  subscription->serializer = Compile(message_id, subscription->attributes);
+  subscription->policy = policy;
+
+  auto &receivers = subscription->receivers;
+  if (!page) {
+    // A native subscription reaches every page and outlives reloads, so it
+    // replaces any the pages made for the same function.
+    receivers.erase(std::remove_if(receivers.begin(), receivers.end(),
+                                   [&receiver](const Receiver &r) {
+                                     return r.function == receiver;
+                                   }),
+                    receivers.end());
+    receivers.push_back({receiver, nullptr});
+  } else if (std::none_of(receivers.begin(), receivers.end(),
+                          [&receiver, page](const Receiver &r) {
+                            return r.function == receiver &&
+                                   (!r.page || r.page == page);
+                          })) {
+    receivers.push_back({receiver, page});
+  }
+  UpdateCalls(*subscription);
+}
+
+void WebviewMessageListener::RemoveReceivers(
+    const char *message_id,
+    const std::function<bool(const Receiver &)> &predicate) {
+  for (auto &subscription : subscriptions_) {
+    if (message_id && subscription.serializer.message_id != message_id)
+      continue;
+    auto &receivers = subscription.receivers;
+    receivers.erase(
+        std::remove_if(receivers.begin(), receivers.end(), predicate),
+        receivers.end());
+    UpdateCalls(subscription);
+  }
+  subscriptions_.erase(
+      std::remove_if(subscriptions_.begin(), subscriptions_.end(),
+                     [](const MessageSubscription &subscription) {
+                       return subscription.receivers.empty();
+                     }),
+      subscriptions_.end());
 }
 
-json WebviewMessageListener::SerializeMessage(
+void WebviewMessageListener::UpdateCalls(MessageSubscription &subscription) {
+  subscription.calls.clear();
+  for (const auto &view : views_) {
+    std::string prefix;
+    int count = 0;
+    for (const auto &receiver : subscription.receivers) {
+      if (receiver.page && receiver.page != view.webview) continue;
+      prefix += receiver.function + "(m);";
+      count++;
+    }
+    if (count == 0) continue;
+    if (count == 1) {
+      // "f(m);" becomes "f(".
+      prefix.resize(prefix.size() - 3);
+    } else {
+      prefix = "(function(m){" + prefix + "})(";
+    }
+    subscription.calls.push_back({view.webview, std::move(prefix)});
+  }
+}
+
+json WebviewMessageListener::SubscribeFromPage(vstwebview::Webview *webview,
+                                               const json &in) {
+  static const std::unordered_map<std::string, MessageAttribute::Type>
+      kTypes = {
+          {"int", MessageAttribute::Type::INT},
+          {"float", MessageAttribute::Type::FLOAT},
+          {"string", MessageAttribute::Type::STRING},
+          {"binary", MessageAttribute::Type::BINARY},
+          {"f32", MessageAttribute::Type::BINARY_F32},
+          {"f64", MessageAttribute::Type::BINARY_F64},
+          {"i16", MessageAttribute::Type::BINARY_I16},
+          {"i32", MessageAttribute::Type::BINARY_I32},
+          {"u8", MessageAttribute::Type::BINARY_U8},
+      };
+  if (in.size() < 3 || !in[0].is_string() || !in[1].is_string() ||
+      !in[2].is_array()) {
+    return false;
+  }
+  std::vector<MessageAttribute> attributes;
+  for (const auto &attr : in[2]) {
+    auto type = kTypes.find(attr.value("type", ""));
+    if (type == kTypes.end()) return false;
+    attributes.push_back({attr.value("name", ""), type->second});
+  }
+  DeliveryPolicy policy;
+  if (in.size() > 3 && in[3].is_object()) {
+    auto mode = in[3].value("mode", "all");
+    if (mode == "latest") {
+      policy.mode = DeliveryPolicy::Mode::LATEST;
+    } else if (mode == "maxRate") {
+      policy.mode = DeliveryPolicy::Mode::MAX_RATE;
+      policy.max_hz = in[3].value("maxHz", 0.0);
+    }
+  }
+  AddReceiver(in[0].get<std::string>(), in[1].get<std::string>(), attributes,
+              policy, webview);
+  return true;
+}
+
+json WebviewMessageListener::UnsubscribeFromPage(vstwebview::Webview *webview,
+                                                 const json &in) {
+  if (in.size() < 2 || !in[0].is_string() || !in[1].is_string()) return false;
+  // A page can only drop its own subscriptions; the other views keep theirs.
+  auto receiver = in[0].get<std::string>();
+  RemoveReceivers(in[1].get<std::string>().c_str(),
+                  [&receiver, webview](const Receiver &r) {
+                    return r.function == receiver && r.page == webview;
+                  });
+  return true;
+}
+
+json WebviewMessageListener::ReplayMessages(vstwebview::Webview *webview,
+                                            const json &in) {
+  uint64_t since =
+      in.empty() || !in[0].is_number() ? 0 : in[0].get<uint64_t>();
+  for (auto &subscription : subscriptions_) {
+    if (!subscription.last_message || subscription.version <= since) continue;
+    // A held message is the newest one, and the next tick would send it to
+    // this page again. Send it to every visible view now instead.
+    if (subscription.pending && webview->visible()) {
+      subscription.pending = nullptr;
+      subscription.stats.merged++;
+      Deliver(subscription, subscription.last_message);
+    } else {
+      Deliver(subscription, subscription.last_message, webview);
+    }
+  }
+  return message_version_;
+}
+
+WebviewMessageListener::DeliveryStats WebviewMessageListener::GetStats(
+    const std::string &message_id) const {
+  auto hash = HashMessageID(message_id);
+  for (const auto &subscription : subscriptions_) {
+    if (subscription.serializer.id_hash == hash &&
+        subscription.serializer.message_id == message_id) {
+      return subscription.stats;
+    }
+  }
+  return {};
+}
+
+// static
+WebviewMessageListener::MessageSerializer WebviewMessageListener::Compile(
+    const std::string &message_id,
+    const std::vector<MessageAttribute> &attributes) {
+  MessageSerializer serializer;
+  serializer.message_id = message_id;
+  serializer.id_hash = HashMessageID(message_id);
+  serializer.prefix = "{\"messageId\":" + json(message_id).dump();
+  for (const auto &attr : attributes) {
+    serializer.attributes.push_back(
+        {attr.name, "," + json(attr.name).dump() + ":", attr.type});
+  }
+  return serializer;
+}
+
+WebviewMessageListener::MessageSubscription *
+WebviewMessageListener::FindSubscription(const char *message_id) {
+  std::string_view id(message_id);
+  auto hash = HashMessageID(id);
+  for (auto &subscription : subscriptions_) {
+    if (subscription.serializer.id_hash == hash &&
+        subscription.serializer.message_id == id) {
+      return &subscription;
+    }
+  }
+  return nullptr;
+}
+
+bool WebviewMessageListener::GetString(
+    Steinberg::Vst::IAttributeList *attributes, const char *name,
+    std::string *out) {
+  // IAttributeList has no way to ask for a string's length, so grow the
+  // buffer until the string fits with its terminator.
+  if (string_buffer_.size() < 128) string_buffer_.resize(128);
+  while (true) {
+    std::fill(string_buffer_.begin(), string_buffer_.end(), 0);
+    auto *buffer =
+        reinterpret_cast<Steinberg::Vst::TChar *>(string_buffer_.data());
+    auto size_in_bytes = static_cast<Steinberg::uint32>(
+        string_buffer_.size() * sizeof(Steinberg::Vst::TChar));
+    if (attributes->getString(name, buffer, size_in_bytes) !=
+        Steinberg::kResultTrue) {
+      return false;
+    }
+    if (string_buffer_.back() == 0 || string_buffer_.size() >= kMaxStringChars)
+      break;
+    string_buffer_.resize(string_buffer_.size() * 2);
+  }
+  *out = VST3::StringConvert::convert(
+      reinterpret_cast<const Steinberg::Vst::TChar *>(string_buffer_.c_str()));
+  return true;
+}
+
+void WebviewMessageListener::SerializeMessage(
     Steinberg::Vst::IMessage *message,
-    const WebviewMessageListener::MessageDescriptor &descriptor) {
+    const WebviewMessageListener::MessageSerializer &serializer,
+    std::string *out) {
   auto attributes = message->getAttributes();
 
-  json j = {{"messageId", message->getMessageID()}};
-  for (const auto &attr : descriptor.attributes) {
+  out->append(serializer.prefix);
+  for (const auto &attr : serializer.attributes) {
+    const char *id = attr.id.c_str();
     switch (attr.type) {
     case MessageAttribute::Type::INT:
       Steinberg::int64 i;
-      if (attributes->getInt(attr.name.c_str(), i) ==
-          Steinberg::kResultTrue) {
-        j[attr.name] = i;
+      if (attributes->getInt(id, i) == Steinberg::kResultTrue) {
+        out->append(attr.key);
+        AppendInt(i, out);
       }
       break;
     case MessageAttribute::Type::FLOAT:
       double f;
-      if (attributes->getFloat(attr.name.c_str(), f) ==
-          Steinberg::kResultTrue) {
-        j[attr.name] = f;
+      if (attributes->getFloat(id, f) == Steinberg::kResultTrue) {
+        out->append(attr.key);
+        AppendDouble(f, out);
       }
       break;
     case MessageAttribute::Type::STRING:
-      Steinberg::Vst::TChar str[128];
-      if (attributes->getString(attr.name.c_str(), str,
-                                128 * sizeof(Steinberg::Vst::TChar)) ==
-          Steinberg::kResultTrue) {
-        j[attr.name] = str;
+      if (GetString(attributes, id, &string_value_)) {
+        out->append(attr.key);
+        out->append(json(string_value_).dump());
       }
       break;
     case MessageAttribute::Type::BINARY:
+    case MessageAttribute::Type::BINARY_F32:
+    case MessageAttribute::Type::BINARY_F64:
+    case MessageAttribute::Type::BINARY_I16:
+    case MessageAttribute::Type::BINARY_I32:
+    case MessageAttribute::Type::BINARY_U8:
       const void *addr;
       Steinberg::uint32 size;
-      if (attributes->getBinary(attr.name.c_str(), addr, size) ==
-          Steinberg::kResultTrue) {
-        std::vector<double> data(size / sizeof(double));
-        std::memcpy(data.data(), addr, size);
-        j[attr.name] = data;
+      if (attributes->getBinary(id, addr, size) == Steinberg::kResultTrue) {
+        out->append(attr.key);
+        out->append("vstwebview.decodeBinary(\"");
+        Base64Encode(addr, size, out);
+        out->append("\",\"");
+        out->append(BinaryElementType(attr.type));
+        out->append("\")");
       }
       break;
     }
   }
-  return j;
+  out->push_back('}');
 }
 
 Steinberg::tresult WebviewMessageListener::Notify(
     Steinberg::Vst::IMessage *message) {
-  auto *msg_id = message->getMessageID();
+  auto *subscription_ptr = FindSubscription(message->getMessageID());
+  if (!subscription_ptr) return Steinberg::kResultFalse;
 
-  const auto &it = subscriptions_.find(msg_id);
-  if (it == subscriptions_.end()) return Steinberg::kResultFalse;
+  auto &subscription = *subscription_ptr;
+  subscription.stats.received++;
+  subscription.version = ++message_version_;
+  subscription.last_message = message;
+  if (subscription.policy.mode == DeliveryPolicy::Mode::ALL &&
+      AnyViewVisible()) {
+    // Anything held while the page was hidden is older than this message.
+    if (subscription.pending) {
+      subscription.pending = nullptr;
+      subscription.stats.merged++;
+    }
+    Deliver(subscription, message);
+    return Steinberg::kResultOk;
+  }
 
-  auto json = SerializeMessage(message, it->second.descriptor);
-  auto send_message_js = it->second.notify_function + "(" + json.dump() + ");";
-  webview_->EvalJS(send_message_js, [](const nlohmann::json &res) {});
+  // Hold on to the newest message; it is serialized only if it is still the
+  // newest when the UI tick comes around. A hidden page gets only the
+  // newest message of each ID once it is shown again.
+  if (subscription.pending) {
+    if (subscription.policy.mode == DeliveryPolicy::Mode::MAX_RATE) {
+      subscription.stats.dropped++;
+    } else {
+      subscription.stats.merged++;
+    }
+  }
+  subscription.pending = message;
   return Steinberg::kResultOk;
 }
 
+void WebviewMessageListener::Deliver(MessageSubscription &subscription,
+                                     Steinberg::Vst::IMessage *message,
+                                     vstwebview::Webview *target) {
+  message_js_.clear();
+  for (const auto &call : subscription.calls) {
+    if (target ? call.webview != target : !call.webview->visible()) continue;
+    if (message_js_.empty()) {
+      SerializeMessage(message, subscription.serializer, &message_js_);
+    }
+    js_.assign(call.prefix);
+    js_.append(message_js_);
+    js_.append(");");
+    call.webview->EvalJS(js_, [](const nlohmann::json &res) {});
+  }
+  // No view had a receiver for it.
+  if (message_js_.empty()) return;
+  subscription.stats.delivered++;
+  subscription.last_delivery = std::chrono::steady_clock::now();
+}
+
+void WebviewMessageListener::FlushPending() {
+  if (!AnyViewVisible()) return;
+  auto now = std::chrono::steady_clock::now();
+  for (auto &subscription : subscriptions_) {
+    if (!subscription.pending) continue;
+    if (subscription.policy.mode == DeliveryPolicy::Mode::MAX_RATE &&
+        subscription.policy.max_hz > 0 &&
+        now - subscription.last_delivery <
+            std::chrono::duration<double>(1.0 / subscription.policy.max_hz)) {
+      continue;
+    }
+    Deliver(subscription, subscription.pending);
+    subscription.pending = nullptr;
+  }
+}
+
+void WebviewMessageListener::OnVisibilityChanged(vstwebview::Webview *webview,
+                                                 bool visible) {
+  auto it = std::find_if(
+      views_.begin(), views_.end(),
+      [webview](const View &view) { return view.webview == webview; });
+  if (it == views_.end()) return;
+  if (!visible) {
+    it->hidden_version = message_version_;
+    return;
+  }
+  // Other views may have been sent what this one missed. Anything still
+  // held goes to every visible view on the next tick anyway.
+  for (auto &subscription : subscriptions_) {
+    if (subscription.pending || !subscription.last_message ||
+        subscription.version <= it->hidden_version) {
+      continue;
+    }
+    Deliver(subscription, subscription.last_message, webview);
+  }
+  it->hidden_version = message_version_;
+}
+
+bool WebviewMessageListener::AnyViewVisible() const {
+  return std::any_of(views_.begin(), views_.end(), [](const View &view) {
+    return view.webview->visible();
+  });
+}
+
 }  // namespace vstwebview
\ No newline at end of file
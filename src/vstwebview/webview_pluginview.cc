@@ -14,10 +14,138 @@
 
 #include "vstwebview/webview_pluginview.h"
 
+#include <algorithm>
+#include <filesystem>
+#include <string>
+
 #include "vstwebview/webview_controller_bindings.h"
 
 namespace vstwebview {
 
+namespace {
+
+// Reports the first frame drawn after the document is parsed, which is when
+// the page can replace the placeholder.
+constexpr char kFirstPaintJS[] = R"(
+(function() {
+  function painted() {
+    requestAnimationFrame(function() {
+      requestAnimationFrame(function() { window._firstPaint(); });
+    });
+  }
+  if (document.readyState === 'loading') {
+    document.addEventListener('DOMContentLoaded', painted);
+  } else {
+    painted();
+  }
+})();
+)";
+
+// Folds the host window's visibility into the Page Visibility API, so pages
+// that pause timers and animations on visibilitychange do so when the
+// editor is covered or minimised, not only when WebKit itself hides it.
+constexpr char kVisibilityJS[] = R"(
+(function() {
+  var vw = window.vstwebview = window.vstwebview || {};
+  var hidden = false;
+  var hiddenDesc = Object.getOwnPropertyDescriptor(Document.prototype,
+                                                   'hidden');
+  var stateDesc = Object.getOwnPropertyDescriptor(Document.prototype,
+                                                  'visibilityState');
+  if (hiddenDesc && stateDesc) {
+    Object.defineProperty(document, 'hidden', {
+      configurable: true,
+      get: function() { return hidden || hiddenDesc.get.call(document); }
+    });
+    Object.defineProperty(document, 'visibilityState', {
+      configurable: true,
+      get: function() {
+        return hidden ? 'hidden' : stateDesc.get.call(document);
+      }
+    });
+  }
+  vw._setHidden = function(h) {
+    if (h === hidden) return;
+    hidden = h;
+    document.dispatchEvent(new Event('visibilitychange'));
+  };
+})();
+)";
+
+// A corner readout of getResourceUsage(), refreshed once a second, for
+// checking a page against its budget while developing it.
+constexpr char kResourceOverlayJS[] = R"(
+(function() {
+  var vw = window.vstwebview = window.vstwebview || {};
+  vw.showResourceOverlay = function() {
+    if (vw._resourceOverlay) return;
+    var el = document.createElement('pre');
+    el.style.cssText = 'position:fixed;right:0;bottom:0;margin:0;' +
+        'padding:4px;font:10px monospace;color:#fff;' +
+        'background:rgba(0,0,0,0.6);pointer-events:none;z-index:2147483647';
+    document.body.appendChild(el);
+    var last = null;
+    function update() {
+      window.getResourceUsage().then(function(u) {
+        var ticks = last ? u.idleTicks - last.idleTicks : 0;
+        var calls = last ? u.calls - last.calls : 0;
+        var pumpMs = last ? (u.pumpSeconds - last.pumpSeconds) * 1000 : 0;
+        var callMs = last ? (u.callSeconds - last.callSeconds) * 1000 : 0;
+        el.textContent =
+            'web ' + (u.webProcessId || '?') + ' ' +
+            u.webProcessCpuPercent.toFixed(1) + '% ' +
+            (u.webProcessRssBytes / 1048576).toFixed(1) + ' MB\n' +
+            'pump ' + pumpMs.toFixed(1) + ' ms/' + ticks + ' ticks\n' +
+            'rpc ' + callMs.toFixed(1) + ' ms/' + calls + ' calls';
+        last = u;
+      });
+    }
+    update();
+    vw._resourceOverlay = {el: el, timer: setInterval(update, 1000)};
+  };
+  vw.hideResourceOverlay = function() {
+    if (!vw._resourceOverlay) return;
+    clearInterval(vw._resourceOverlay.timer);
+    vw._resourceOverlay.el.remove();
+    delete vw._resourceOverlay;
+  };
+})();
+)";
+
+// Pages register handlers to drop their own caches (decoded images, large
+// arrays) before a collection.
+constexpr char kMemoryPressureJS[] = R"(
+(function() {
+  var vw = window.vstwebview = window.vstwebview || {};
+  var handlers = [];
+  vw.onMemoryPressure = function(fn) { handlers.push(fn); };
+  vw._releaseMemory = function() {
+    handlers.forEach(function(fn) {
+      try { fn(); } catch (e) { console.error(e); }
+    });
+  };
+})();
+)";
+
+nlohmann::json ToJSON(const ResourceUsage &usage) {
+  return {{"webProcessId", usage.web_process_id},
+          {"webProcessCpuSeconds", usage.web_process_cpu_seconds},
+          {"webProcessCpuPercent", usage.web_process_cpu_percent},
+          {"webProcessRssBytes", usage.web_process_rss_bytes},
+          {"pumpSeconds", usage.pump_seconds},
+          {"idleTicks", usage.idle_ticks},
+          {"callSeconds", usage.call_seconds},
+          {"calls", usage.calls}};
+}
+
+void SetPageHidden(Webview *webview, bool hidden) {
+  webview->EvalJS(std::string("vstwebview._setHidden(") +
+                      (hidden ? "true" : "false") + ");",
+                  [](const nlohmann::json &r) {});
+}
+
+}  // namespace
+
 WebviewPluginView::WebviewPluginView(
     Steinberg::Vst::EditController *controller,
     const std::string &title,
@@ -25,7 +153,11 @@ WebviewPluginView::WebviewPluginView(
     Steinberg::ViewRect *size,
     const std::string &uri)
     : Steinberg::Vst::EditorView(controller, size), title_(title),
-      bindings_(bindings), uri_(uri) {}
+      bindings_(bindings), uri_(uri) {
+#ifdef DEVELOPMENT
+  webview_options_ = WebviewOptions::Debug();
+#endif
+}
 
 Steinberg::tresult WebviewPluginView::isPlatformTypeSupported(
     Steinberg::FIDString type) {
@@ -35,24 +167,201 @@ Steinberg::tresult WebviewPluginView::isPlatformTypeSupported(
 Steinberg::tresult WebviewPluginView::onSize(Steinberg::ViewRect *newSize) {
   {
     std::lock_guard<std::mutex> webview_lock(webview_mutex_);
-    if (webview_handle_) {
-      webview_handle_->SetViewSize(newSize->getWidth(), newSize->getHeight(),
-                                   vstwebview::Webview::SizeHint::kNone);
-    }
+    pending_width_ = newSize->getWidth();
+    pending_height_ = newSize->getHeight();
   }
   return Steinberg::Vst::EditorView::onSize(newSize);
 }
 
+void WebviewPluginView::ApplyPendingSize(vstwebview::Webview *webview) {
+  std::lock_guard<std::mutex> webview_lock(webview_mutex_);
+  if (pending_width_ != applied_width_ || pending_height_ != applied_height_) {
+    webview->SetViewSize(pending_width_, pending_height_,
+                         vstwebview::Webview::SizeHint::kNone);
+    applied_width_ = pending_width_;
+    applied_height_ = pending_height_;
+    resize_notify_pending_ = true;
+    return;
+  }
+  if (resize_notify_pending_) {
+    resize_notify_pending_ = false;
+    webview->EvalJS("if(window.notifyViewResize){notifyViewResize(" +
+                        std::to_string(applied_width_) + "," +
+                        std::to_string(applied_height_) + ");}",
+                    [](const nlohmann::json &r) {});
+  }
+}
+
+Steinberg::tresult WebviewPluginView::checkSizeConstraint(
+    Steinberg::ViewRect *rect) {
+  if (!resizable_) return Steinberg::kResultFalse;
+  int width = std::max(rect->getWidth(), min_width_);
+  int height = std::max(rect->getHeight(), min_height_);
+  if (max_width_ > 0) width = std::min(width, max_width_);
+  if (max_height_ > 0) height = std::min(height, max_height_);
+  rect->right = rect->left + width;
+  rect->bottom = rect->top + height;
+  return Steinberg::kResultTrue;
+}
+
+void WebviewPluginView::SetSizeLimits(int min_width, int min_height,
+                                      int max_width, int max_height) {
+  std::lock_guard<std::mutex> webview_lock(webview_mutex_);
+  resizable_ = true;
+  min_width_ = min_width;
+  min_height_ = min_height;
+  max_width_ = max_width;
+  max_height_ = max_height;
+  if (webview_handle_) ApplySizeLimits(webview_handle_.get());
+}
+
+void WebviewPluginView::ReleaseMemory() {
+  std::lock_guard<std::mutex> webview_lock(webview_mutex_);
+  if (webview_handle_) ReleasePageMemory(webview_handle_.get());
+  for (auto binding : bindings_) {
+    binding->ReleaseMemory();
+  }
+}
+
+void WebviewPluginView::ReleasePageMemory(vstwebview::Webview *webview) {
+  webview->EvalJS("vstwebview._releaseMemory();",
+                  [](const nlohmann::json &r) {});
+  webview->ReleaseMemory();
+}
+
+void WebviewPluginView::CheckHiddenRelease(vstwebview::Webview *webview) {
+  if (webview->visible() || hidden_released_ ||
+      hidden_release_delay_ == std::chrono::steady_clock::duration::zero() ||
+      std::chrono::steady_clock::now() - hidden_since_ <
+          hidden_release_delay_) {
+    return;
+  }
+  hidden_released_ = true;
+  ReleasePageMemory(webview);
+  for (auto binding : bindings_) {
+    binding->ReleaseMemoryFor(webview);
+  }
+}
+
+bool WebviewPluginView::GetResourceUsage(ResourceUsage *usage) {
+  std::lock_guard<std::mutex> webview_lock(webview_mutex_);
+  if (!webview_handle_) return false;
+  *usage = webview_handle_->GetResourceUsage();
+  return true;
+}
+
+void WebviewPluginView::SetPlaceholder(const std::string &png_path,
+                                       const std::string &cache_path) {
+  placeholder_path_ = png_path;
+  placeholder_cache_path_ = cache_path;
+}
+
+void WebviewPluginView::ApplySizeLimits(vstwebview::Webview *webview) {
+  webview->SetSizeLimits(min_width_, min_height_, max_width_, max_height_);
+}
+
 void WebviewPluginView::attachedToParent() {
   if (!webview_handle_) {
+    open_timing_.Start();
     auto init_function = [this](vstwebview::Webview *webview) {
+      using Phase = EditorOpenTiming::Phase;
+      open_timing_.Mark(Phase::kWebviewCreated);
+      load_callback_id_ =
+          webview->AddLoadCallback([this, webview](Webview::LoadEvent event) {
+            switch (event) {
+              case Webview::LoadEvent::kStarted:
+                open_timing_.Mark(Phase::kLoadStarted);
+                break;
+              case Webview::LoadEvent::kCommitted:
+                open_timing_.Mark(Phase::kLoadCommitted);
+                break;
+              case Webview::LoadEvent::kFinished:
+                open_timing_.Mark(Phase::kLoadFinished);
+                // A page loaded while hidden starts out believing it is
+                // visible.
+                if (!webview->visible()) SetPageHidden(webview, true);
+                break;
+            }
+          });
+      visibility_callback_id_ = webview->AddVisibilityCallback(
+          [this, webview](bool visible) {
+            SetPageHidden(webview, !visible);
+            hidden_since_ = std::chrono::steady_clock::now();
+            hidden_released_ = false;
+          });
+      webview->OnDocumentCreate(kVisibilityJS);
+      webview->OnDocumentCreate(kMemoryPressureJS);
+      call_observer_id_ = webview->AddCallObserver(
+          [this](const std::string &name,
+                 std::chrono::steady_clock::duration) {
+            if (name != "_firstPaint") open_timing_.Mark(Phase::kFirstCall);
+          });
+      webview->BindNotification(
+          "_firstPaint",
+          [this](Webview *webview, int, const std::string &,
+                 const nlohmann::json &) {
+            open_timing_.Mark(Phase::kFirstPaint);
+            webview->HidePlaceholder();
+            return nlohmann::json();
+          });
+      webview->OnDocumentCreate(kFirstPaintJS);
+      std::error_code error;
+      if (!placeholder_cache_path_.empty() &&
+          std::filesystem::exists(placeholder_cache_path_, error)) {
+        webview->ShowPlaceholder(placeholder_cache_path_);
+      } else if (!placeholder_path_.empty()) {
+        webview->ShowPlaceholder(placeholder_path_);
+      }
+      webview->BindNotification(
+          "editorReady",
+          [this](Webview *webview, int, const std::string &,
+                 const nlohmann::json &) {
+            open_timing_.Mark(Phase::kFirstCall);
+            open_timing_.Mark(Phase::kReady);
+            if (!placeholder_cache_path_.empty()) {
+              webview->SaveSnapshot(placeholder_cache_path_);
+            }
+            return nlohmann::json();
+          });
+      webview->BindFunction(
+          "getResourceUsage",
+          [](Webview *webview, int, const std::string &,
+             const nlohmann::json &) {
+            return ToJSON(webview->GetResourceUsage());
+          });
+      webview->OnDocumentCreate(kResourceOverlayJS);
+      webview->BindFunction(
+          "getEditorOpenTiming",
+          [this](Webview *, int, const std::string &, const nlohmann::json &) {
+            return open_timing_.ToJSON();
+          });
+
       for (auto binding : bindings_) {
         binding->Bind(webview);
       }
+      webview->UpdateDocumentScript();
+      open_timing_.Mark(Phase::kBindingsInjected);
       webview->SetTitle(title_);
-      webview->SetViewSize(rect.getWidth(), rect.getHeight(),
-                           vstwebview::Webview::SizeHint::kFixed);
+      {
+        std::lock_guard<std::mutex> webview_lock(webview_mutex_);
+        applied_width_ = pending_width_ = rect.getWidth();
+        applied_height_ = pending_height_ = rect.getHeight();
+        if (resizable_) {
+          webview->SetViewSize(applied_width_, applied_height_,
+                               vstwebview::Webview::SizeHint::kNone);
+          ApplySizeLimits(webview);
+        } else {
+          webview->SetViewSize(applied_width_, applied_height_,
+                               vstwebview::Webview::SizeHint::kFixed);
+        }
+      }
+      idle_callback_id_ = webview->AddIdleCallback(
+          [this, webview]() {
+            ApplyPendingSize(webview);
+            CheckHiddenRelease(webview);
+          });
 
+      open_timing_.Mark(Phase::kNavigate);
       if (!uri_.empty()) {
           webview->Navigate(uri_);
       } else {
@@ -61,7 +370,8 @@ void WebviewPluginView::attachedToParent() {
     };
 
     webview_handle_ =
-        vstwebview::MakeWebview(true, plugFrame, systemWindow, init_function);
+        vstwebview::MakeWebview(webview_options_, plugFrame, systemWindow,
+                                init_function);
   }
 
   EditorView::attachedToParent();
@@ -72,19 +382,40 @@ Steinberg::tresult WebviewPluginView::setFrame(Steinberg::IPlugFrame *frame) {
 }
 
 Steinberg::tresult WebviewPluginView::onFocus(Steinberg::TBool a_bool) {
+  // Losing focus says nothing about visibility, but an editor that gains it
+  // is certainly on screen.
+  std::lock_guard<std::mutex> webview_lock(webview_mutex_);
+  if (a_bool && webview_handle_) webview_handle_->SetVisible(true);
   return Steinberg::kResultOk;
 }
 
 void WebviewPluginView::removedFromParent() {
-  if (webview_handle_) {
-    webview_handle_->Terminate();
+  std::unique_ptr<vstwebview::Webview> webview;
+  {
+    std::lock_guard<std::mutex> webview_lock(webview_mutex_);
+    webview = std::move(webview_handle_);
+  }
+  if (webview) {
+    webview->RemoveIdleCallback(idle_callback_id_);
+    webview->RemoveLoadCallback(load_callback_id_);
+    webview->RemoveCallObserver(call_observer_id_);
+    webview->RemoveVisibilityCallback(visibility_callback_id_);
+    for (auto binding : bindings_) {
+      // Bindings may be shared with other open views, so each releases its
+      // own caches once its last view has gone.
+      binding->Unbind(webview.get());
+    }
+    // Destroy the webview now rather than with the view, so the next
+    // attachedToParent starts from scratch and nothing lingers in between.
+    webview->Terminate();
+    webview.reset();
   }
 
   EditorView::removedFromParent();
 }
 
 Steinberg::tresult WebviewPluginView::canResize() {
-  return Steinberg::kResultFalse;
+  return resizable_ ? Steinberg::kResultTrue : Steinberg::kResultFalse;
 }
 
 }  // namespace vstwebview
@@ -34,10 +34,26 @@ EdgeChromiumBrowser::EdgeChromiumBrowser(HWND parent_window, bool debug,
           this, &EdgeChromiumBrowser::OnPermissionRequested);
 }
 
-EdgeChromiumBrowser::~EdgeChromiumBrowser() {
-  wv2_controller_->Release();
-  webview2_->Release();
-  settings_->Release();
+EdgeChromiumBrowser::~EdgeChromiumBrowser() { Terminate(); }
+
+void EdgeChromiumBrowser::Terminate() {
+  // Close the controller while its parent window still exists, then let the
+  // base class destroy the window. Creation is asynchronous, so any of these
+  // may not exist yet.
+  if (wv2_controller_) {
+    wv2_controller_->Close();
+    wv2_controller_->Release();
+    wv2_controller_ = nullptr;
+  }
+  if (webview2_) {
+    webview2_->Release();
+    webview2_ = nullptr;
+  }
+  if (settings_) {
+    settings_->Release();
+    settings_ = nullptr;
+  }
+  WebviewWin32::Terminate();
 }
 
 HRESULT EdgeChromiumBrowser::OnWebMessageReceived(
@@ -63,7 +79,7 @@ HRESULT EdgeChromiumBrowser::OnPermissionRequested(
 
 HRESULT EdgeChromiumBrowser::OnEnvironmentCreated(
     HRESULT result, ICoreWebView2Environment *environment) {
-  if (!SUCCEEDED(result)) {
+  if (!SUCCEEDED(result) || !window_) {
     return E_FAIL;
   }
   environment->CreateCoreWebView2Controller(
@@ -76,6 +92,11 @@ HRESULT EdgeChromiumBrowser::OnControllerCreated(
   if (!SUCCEEDED(result) || !controller) {
     return E_FAIL;
   }
+  if (!window_) {
+    // Terminated while the controller was being created.
+    controller->Close();
+    return E_ABORT;
+  }
 
   wv2_controller_ = controller;
   wv2_controller_->AddRef();
@@ -108,6 +129,40 @@ HRESULT EdgeChromiumBrowser::OnControllerCreated(
     return E_FAIL;
   }
 
+  webview2_->add_NavigationStarting(
+      Callback<ICoreWebView2NavigationStartingEventHandler>(
+          [this](ICoreWebView2 *,
+                 ICoreWebView2NavigationStartingEventArgs *) -> HRESULT {
+            OnLoadEvent(LoadEvent::kStarted);
+            return S_OK;
+          })
+          .Get(),
+      &token);
+  webview2_->add_ContentLoading(
+      Callback<ICoreWebView2ContentLoadingEventHandler>(
+          [this](ICoreWebView2 *,
+                 ICoreWebView2ContentLoadingEventArgs *) -> HRESULT {
+            OnLoadEvent(LoadEvent::kCommitted);
+            return S_OK;
+          })
+          .Get(),
+      &token);
+  webview2_->add_NavigationCompleted(
+      Callback<ICoreWebView2NavigationCompletedEventHandler>(
+          [this](ICoreWebView2 *,
+                 ICoreWebView2NavigationCompletedEventArgs *) -> HRESULT {
+            OnLoadEvent(LoadEvent::kFinished);
+            return S_OK;
+          })
+          .Get(),
+      &token);
+
+  // ReleaseMemory hides the controller so it can be suspended; showing it
+  // again resumes the page.
+  AddVisibilityCallback([this](bool visible) {
+    if (visible && wv2_controller_) wv2_controller_->put_IsVisible(TRUE);
+  });
+
   webview2_->AddRef();
 
   OnDocumentCreate(
@@ -139,14 +194,50 @@ void EdgeChromiumBrowser::Resize() {
   wv2_controller_->put_Bounds(bounds);
 }
 
-void EdgeChromiumBrowser::Navigate(const std::string &url) {
+void EdgeChromiumBrowser::ReleaseMemory() {
+  // WebView2 only trims the memory of a suspended webview, and only a
+  // hidden one can be suspended.
+  if (!webview2_ || visible()) return;
+  ICoreWebView2_3 *webview_2_3 = nullptr;
+  if (webview2_->QueryInterface(IID_PPV_ARGS(&webview_2_3)) != S_OK) return;
+  wv2_controller_->put_IsVisible(FALSE);
+  webview_2_3->TrySuspend(
+      Callback<ICoreWebView2TrySuspendCompletedHandler>(
+          [](HRESULT, BOOL) -> HRESULT { return S_OK; })
+          .Get());
+  webview_2_3->Release();
+}
+
+void EdgeChromiumBrowser::DoNavigate(const std::string &url) {
   auto wurl = winrt::to_hstring(url);
   webview2_->Navigate(wurl.c_str());
 }
 
-void EdgeChromiumBrowser::OnDocumentCreate(const std::string &js) {
+void EdgeChromiumBrowser::SetDocumentScript(const std::string &js) {
+  if (!webview2_) return;
+  if (!document_script_id_.empty()) {
+    webview2_->RemoveScriptToExecuteOnDocumentCreated(
+        document_script_id_.c_str());
+    document_script_id_.clear();
+  }
+  using AddScriptHandler =
+      ICoreWebView2AddScriptToExecuteOnDocumentCreatedCompletedHandler;
   auto wjs = winrt::to_hstring(js);
-  webview2_->AddScriptToExecuteOnDocumentCreated(wjs.c_str(), nullptr);
+  int generation = ++document_script_generation_;
+  webview2_->AddScriptToExecuteOnDocumentCreated(
+      wjs.c_str(),
+      Callback<AddScriptHandler>(
+          [this, generation](HRESULT result, LPCWSTR id) -> HRESULT {
+            if (!SUCCEEDED(result) || !webview2_) return S_OK;
+            if (generation == document_script_generation_) {
+              document_script_id_ = id;
+            } else {
+              // Replaced before its id arrived.
+              webview2_->RemoveScriptToExecuteOnDocumentCreated(id);
+            }
+            return S_OK;
+          })
+          .Get());
 }
 
 void EdgeChromiumBrowser::EvalJS(const std::string &js, ResultCallback rs) {
@@ -39,14 +39,16 @@ class EdgeChromiumBrowser : public WebviewWin32 {
   ~EdgeChromiumBrowser() override;
 
   bool Embed() override;
+  void Terminate() override;
 
-  void Navigate(const std::string &url) override;
-  void OnDocumentCreate(const std::string &js) override;
   void EvalJS(const std::string &js, ResultCallback rs) override;
+  void ReleaseMemory() override;
   void DispatchIn(DispatchFunction f) override;
 
  protected:
   void Resize() override;
+  void DoNavigate(const std::string &url) override;
+  void SetDocumentScript(const std::string &js) override;
 
  private:
   HRESULT OnControllerCreated(HRESULT result,
@@ -74,7 +76,11 @@ class EdgeChromiumBrowser : public WebviewWin32 {
       message_received_handler_;
   Microsoft::WRL::ComPtr<ICoreWebView2PermissionRequestedEventHandler>
       permission_requested_handler_;
-  ICoreWebView2Settings *settings_;
+  ICoreWebView2Settings *settings_ = nullptr;
+
+  // Ids arrive asynchronously; the generation tells a stale one apart.
+  std::wstring document_script_id_;
+  int document_script_generation_ = 0;
 };
 
 }  // namespace vstwebview
\ No newline at end of file
@@ -34,13 +34,19 @@ WebviewWin32::WebviewWin32(HWND parent_window, bool debug,
             GetWindowLongPtr(hwnd, GWLP_USERDATA));
         switch (msg) {
           case WM_SIZE:
-            w->Resize();
+            if (w) w->Resize();
+            break;
+          case WM_TIMER:
+            if (w && wp == kIdleTimerId) {
+              w->UpdateVisibility();
+              w->OnIdle();
+            }
             break;
           case WM_CLOSE:
             DestroyWindow(hwnd);
             break;
           case WM_DESTROY:
-            w->Terminate();
+            if (w) w->Terminate();
             break;
           case WM_GETMINMAXINFO: {
             auto lpmmi = (LPMINMAXINFO)lp;
@@ -78,10 +84,32 @@ WebviewWin32::WebviewWin32(HWND parent_window, bool debug,
   UpdateWindow(window_);
   SetFocus(window_);
 
+  // Drive idle callbacks roughly 60 times a second.
+  SetTimer(window_, kIdleTimerId, 16, nullptr);
+
   Resize();
 }
 
-void WebviewWin32::Terminate() {}
+WebviewWin32::~WebviewWin32() { Terminate(); }
+
+void WebviewWin32::UpdateVisibility() {
+  // As a child window the editor gets no minimise or hide messages of its
+  // own when the host's window changes, so poll instead. IsWindowVisible
+  // already accounts for every ancestor's visibility.
+  HWND root = GetAncestor(window_, GA_ROOT);
+  SetVisible(IsWindowVisible(window_) && !(root && IsIconic(root)));
+}
+
+void WebviewWin32::Terminate() {
+  // Detach from the window first so messages sent while it is destroyed
+  // (including WM_DESTROY) no longer reach this object.
+  if (!window_) return;
+  HWND window = window_;
+  window_ = nullptr;
+  KillTimer(window, kIdleTimerId);
+  SetWindowLongPtr(window, GWLP_USERDATA, 0);
+  DestroyWindow(window);
+}
 
 void WebviewWin32::SetTitle(const std::string &title) {
   SetWindowTextW(window_, winrt::to_hstring(title).c_str());
@@ -141,12 +169,13 @@ std::string WebviewWin32::ContentRootURI() const {
 }
 
 // static
-std::unique_ptr<Webview> MakeWebview(bool debug,
+std::unique_ptr<Webview> MakeWebview(const WebviewOptions &options,
                                      Steinberg::IPlugFrame *plug_frame,
                                      void *window,
                                      WebviewCreatedCallback created_cb) {
   auto webview =
-      std::make_unique<EdgeChromiumBrowser>((HWND)window, debug, created_cb);
+      std::make_unique<EdgeChromiumBrowser>((HWND)window, options.debug,
+                                            created_cb);
   if (webview->Embed()) {
     return std::move(webview);
   }
@@ -36,7 +36,7 @@ class WebviewWin32 : public Webview {
  public:
   WebviewWin32(HWND parent_window, bool debug,
                WebviewCreatedCallback created_cb);
-  ~WebviewWin32() override = default;
+  ~WebviewWin32() override;
 
   virtual bool Embed() = 0;
 
@@ -49,6 +49,10 @@ class WebviewWin32 : public Webview {
 
  protected:
   virtual void Resize(){};
+  // Polled from the idle timer; see the implementation.
+  void UpdateVisibility();
+
+  static constexpr UINT_PTR kIdleTimerId = 1;
 
  protected:
   HWND window_;